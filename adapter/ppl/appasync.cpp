@@ -62,10 +62,26 @@ namespace concurrency_
         }
     };
 
+    struct IoPoolTaskpplSchedule : public concurrency::scheduler_interface
+    {
+        virtual void schedule(concurrency::TaskProc_t proc, void* param)
+        {
+            WorkerPool::asyncIo([proc, param]() {
+                proc(param);
+            });
+        }
+    };
+
 
     std::shared_ptr<concurrency::scheduler_interface>& static_pplScheduler()
     {
         static std::shared_ptr<concurrency::scheduler_interface>  s = std::make_shared<WorkerPoolTaskpplSchedule>();
         return s;
     }
+
+    std::shared_ptr<concurrency::scheduler_interface>& static_pplIoScheduler()
+    {
+        static std::shared_ptr<concurrency::scheduler_interface>  s = std::make_shared<IoPoolTaskpplSchedule>();
+        return s;
+    }
 }
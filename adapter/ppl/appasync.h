@@ -20,6 +20,8 @@ namespace AppUI
 namespace concurrency_
 {
     std::shared_ptr<concurrency::scheduler_interface>& static_pplScheduler();
+    //runs on WorkerPool::ioPool(), for continuations that block
+    std::shared_ptr<concurrency::scheduler_interface>& static_pplIoScheduler();
 
     template<class T>
     class task_completion_event_once
@@ -72,6 +74,12 @@ namespace concurrency_
         return concurrency::create_task(_Param, concurrency::task_options(AppUI::static_pplScheduler()));
     }
 
+    template<typename _Ty>
+    __forceinline auto asyncOnIO(_Ty _Param)
+    {
+        return concurrency::create_task(_Param, concurrency::task_options(concurrency_::static_pplIoScheduler()));
+    }
+
     template<typename T>
     __forceinline auto asyncWait(const concurrency::task_completion_event<T>& _Event)
     {
@@ -109,6 +117,12 @@ namespace concurrency_
         F _Func;
     };
 
+    template<class F>
+    struct IOThenHolder
+    {
+        F _Func;
+    };
+
     template<class T, class F >
     __forceinline auto operator | (const concurrency::task<T>& _Task, PoolThenHolder<F>&& h)
     {
@@ -121,6 +135,12 @@ namespace concurrency_
         return _Task.then(h._Func, concurrency::task_options(AppUI::static_pplScheduler()));
     }
 
+    template<class T, class F >
+    __forceinline auto operator | (const concurrency::task<T>& _Task, IOThenHolder<F>&& h)
+    {
+        return _Task.then(h._Func, concurrency::task_options(concurrency_::static_pplIoScheduler()));
+    }
+
     template<class F>
     __forceinline auto _Pool(const F& _Func)
     {
@@ -133,6 +153,12 @@ namespace concurrency_
         return UIThenHolder<F>{_Func};
     }
 
+    template<class F>
+    __forceinline auto _IO(const F& _Func)
+    {
+        return IOThenHolder<F>{_Func};
+    }
+
     struct Pool_
     {
         template<class F>
@@ -151,6 +177,15 @@ namespace concurrency_
         }
     };
 
+    struct IO_
+    {
+        template<class F>
+        __forceinline auto operator()(const F& _Func) const
+        {
+            return _IO(_Func);
+        }
+    };
+
     template<class R>
     struct DelayThen
     {
@@ -231,6 +266,7 @@ namespace concurrency_
 
         static const auto pool = concurrency_::Pool_();
         static const auto ui = concurrency_::UI_();
+        static const auto io = concurrency_::IO_();
     }
 
     ///---------------
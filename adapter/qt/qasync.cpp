@@ -1,6 +1,7 @@
 #include "stable.h"
 #include "qasync.h"
 #include "time/timetick.h"
+#include "thread/executors.h"
 
 namespace
 {
@@ -29,7 +30,7 @@ namespace
         }
 
         WrapTask(Callback0&& func)
-            : func_(func)
+            : func_(std::move(func))
         {
 
         }
@@ -87,23 +88,33 @@ class QxApplicationPrivate
     QxApplication* q_ptr;
     std::atomic<int> taskSeq_ = 0;
     std::thread::id thread_id_;
+
+    //ui thread time spent on posted tasks per pass, the rest goes back to the event loop
+    static const int64_t k_passBudgetMicroSecs = 8000;
+    //rebuild the delay heap once cancelled entries outnumber live ones
+    static const size_t k_compactMinSize = 64;
+
 public:
     QxApplicationPrivate(QxApplication* q) : q_ptr(q)
         , thread_id_(std::this_thread::get_id())
     {
-
+        m_delayTimer.setSingleShot(true);
+        QObject::connect(&m_delayTimer, SIGNAL(timeout()), q_ptr, SLOT(runQueue()));
     }
 
-    void add(WrapTask&& task)
+    int add(WrapTask&& task)
     {
-        if (m_quit) { return; }
-
-        std::lock_guard<std::mutex> lock(m_taskQueueLock);
-        taskSeq_ += 1;
-        task.seq_ = taskSeq_;
-        m_taskQueue.push_back(std::move(task));
-        QAppAsyncEvent* ev = new QAppAsyncEvent();
-        qApp->postEvent(qApp, ev);
+        if (m_quit) { return 0; }
+
+        int seq = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_taskQueueLock);
+            seq = ++taskSeq_;
+            task.seq_ = seq;
+            m_taskQueue.push_back(std::move(task));
+        }
+        wake();
+        return seq;
     }
 
     void post(Callback0&& task)
@@ -116,88 +127,210 @@ public:
         add(task);
     }
 
-    void postDelayed(Callback0&& task, int milliSeconds)
+    int postDelayed(Callback0&& task, int milliSeconds)
     {
-        add(WrapTask(std::move(task), TimeTick::now().addMilliSecs(milliSeconds)));
+        return add(WrapTask(std::move(task), TimeTick::now().addMilliSecs(milliSeconds)));
     }
 
-    void postDelayed(const Callback0& task, int milliSeconds)
+    int postDelayed(const Callback0& task, int milliSeconds)
     {
-        add(WrapTask(task, TimeTick::now().addMilliSecs(milliSeconds)));
+        return add(WrapTask(task, TimeTick::now().addMilliSecs(milliSeconds)));
+    }
+
+    void cancelDelayed(int id)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_taskQueueLock);
+            m_cancelQueue.push_back(id);
+        }
+        m_cancelPending = true;
+        wake();
+    }
+
+    //at most one async event in flight, whatever is queued meanwhile rides along
+    void wake()
+    {
+        if (!m_wakePending.exchange(true, std::memory_order_acq_rel))
+        {
+            qApp->postEvent(qApp, new QAppAsyncEvent());
+        }
+    }
+
+    void onWake()
+    {
+        //cleared before collecting, so a post racing with this pass wakes us again
+        m_wakePending.store(false, std::memory_order_release);
+        runOnce();
     }
 
     void runOnce()
     {
-        runTaskQueue();
-        runDelayQueue();
-        if (!nextDelay_.isNull())
+        TimeTick deadline = TimeTick::now().addMicroSecs(k_passBudgetMicroSecs);
+
+        collect();
+        bool done = runTaskQueue(deadline) && runDelayQueue(deadline);
+        if (!done)
         {
-            auto now = TimeTick::now();
-            int toWait = qMax(1, (int)((nextDelay_ - now).milliSecs()));
-            QTimer::singleShot(toWait, q_ptr, SLOT(runQueue()));
+            //out of budget, let input and paint events in before the rest
+            wake();
         }
+        armTimer();
     }
 
-    void runTaskQueue()
+    //moves posted tasks and cancels over to the ui thread side
+    void collect()
     {
         std::deque<WrapTask> taskQueue;
+        std::vector<int> cancelQueue;
         {
             std::lock_guard<std::mutex> lock(m_taskQueueLock);
-            taskQueue = std::move(m_taskQueue);
+            taskQueue.swap(m_taskQueue);
+            cancelQueue.swap(m_cancelQueue);
+            m_cancelPending = false;
         }
-        auto now = TimeTick::now();
 
-        for (auto it = taskQueue.begin(); it != taskQueue.end(); ++it)
+        for (auto& task : taskQueue)
         {
-            if (it->run.isNull())
+            if (task.run.isNull())
             {
-                it->invoke();
+                m_readyQueue.push_back(std::move(task));
             }
             else
             {
-                if (now >= it->run)
-                {
-                    it->invoke();
-                    now = TimeTick::now();
-                }
-                else
-                {
-                    m_delayQueue.push(std::move(*it));
-                }
+                m_delayLive.insert(task.seq_);
+                m_delayHeap.push_back(std::move(task));
+                std::push_heap(m_delayHeap.begin(), m_delayHeap.end());
+            }
+        }
+
+        for (int id : cancelQueue)
+        {
+            //the entry stays in the heap and is dropped when it reaches the top
+            if (m_delayLive.erase(id))
+            {
+                m_delayDead += 1;
             }
         }
+
+        if (m_delayDead > k_compactMinSize && m_delayDead > m_delayLive.size())
+        {
+            compactDelayHeap();
+        }
     }
 
-    void runDelayQueue()
+    //false if the budget ran out before the queue did
+    bool runTaskQueue(const TimeTick& deadline)
+    {
+        while (!m_readyQueue.empty())
+        {
+            WrapTask task = std::move(m_readyQueue.front());
+            m_readyQueue.pop_front();
+            task.invoke();
+
+            if (TimeTick::now() >= deadline)
+            {
+                return m_readyQueue.empty();
+            }
+        }
+        return true;
+    }
+
+    bool runDelayQueue(const TimeTick& deadline)
     {
         auto now = TimeTick::now();
 
-        while (true)
+        while (!m_delayHeap.empty())
         {
-            if (m_delayQueue.empty() || m_delayQueue.top().run > now)
+            if (m_cancelPending)
+            {
+                //a task that just ran may have cancelled one due in this pass
+                collect();
+                continue;
+            }
+
+            if (popDead())
+            {
+                continue;
+            }
+            if (m_delayHeap.front().run > now)
             {
                 break;
             }
-            WrapTask task = std::move(const_cast<WrapTask&>(m_delayQueue.top()));
-            m_delayQueue.pop();
+            if (now >= deadline)
+            {
+                return false;
+            }
+
+            std::pop_heap(m_delayHeap.begin(), m_delayHeap.end());
+            WrapTask task = std::move(m_delayHeap.back());
+            m_delayHeap.pop_back();
+            m_delayLive.erase(task.seq_);
             task.invoke();
             now = TimeTick::now();
         }
+        return true;
+    }
+
+    bool popDead()
+    {
+        if (m_delayLive.count(m_delayHeap.front().seq_))
+        {
+            return false;
+        }
+        std::pop_heap(m_delayHeap.begin(), m_delayHeap.end());
+        m_delayHeap.pop_back();
+        m_delayDead -= 1;
+        return true;
+    }
+
+    void compactDelayHeap()
+    {
+        auto live = [this](const WrapTask& task) {
+            return m_delayLive.count(task.seq_) != 0;
+        };
+        m_delayHeap.erase(std::stable_partition(m_delayHeap.begin(), m_delayHeap.end(), live), m_delayHeap.end());
+        std::make_heap(m_delayHeap.begin(), m_delayHeap.end());
+        m_delayDead = 0;
+    }
+
+    //one timer for all delayed tasks, only restarted when the earliest deadline moved
+    void armTimer()
+    {
+        while (!m_delayHeap.empty() && popDead())
+        {
+        }
 
-        if (m_delayQueue.empty())
+        if (m_delayHeap.empty())
         {
+            m_delayTimer.stop();
             nextDelay_.setZero();
+            return;
         }
-        else
+
+        TimeTick next = m_delayHeap.front().run;
+        if (m_delayTimer.isActive() && next == nextDelay_)
         {
-            nextDelay_ = m_delayQueue.top().run;
+            return;
         }
+
+        nextDelay_ = next;
+        int toWait = qMax(0, (int)((next - TimeTick::now()).milliSecs()) + 1);
+        m_delayTimer.start(toWait);
     }
 
     std::atomic<bool> m_quit = false;
+    std::atomic<bool> m_wakePending = false;
+    std::atomic<bool> m_cancelPending = false;
     std::mutex m_taskQueueLock;
     std::deque<WrapTask> m_taskQueue;
-    std::priority_queue<WrapTask> m_delayQueue;
+    std::vector<int> m_cancelQueue;
+
+    //ui thread only
+    std::deque<WrapTask> m_readyQueue;
+    std::vector<WrapTask> m_delayHeap;
+    std::set<int> m_delayLive;
+    size_t m_delayDead = 0;
+    QTimer m_delayTimer;
     TimeTick nextDelay_;
 };
 
@@ -210,10 +343,12 @@ QxApplication::QxApplication(int argc, char* argv[])
     , d_ptr(new QxApplicationPrivate(this))
 {
     g_appPriv = d_ptr;
+    Executors::set("ui", Qx::executor());
 }
 
 QxApplication::~QxApplication()
 {
+    Executors::set("ui", nullptr);
     delete d_ptr;
 }
 
@@ -237,7 +372,7 @@ bool QxApplication::event(QEvent* ev)
 {
     if (ev->type() == QAppAsyncEvent::k_qAppAsyncEventType)
     {
-        runQueue();
+        d_ptr->onWake();
         ev->accept();
         return true;
     }
@@ -252,9 +387,14 @@ namespace Qx
         g_appPriv->post(cb);
     }
 
-    void Qx::asyncDelayed(const std::function<void()>& cb, int milliSecs)
+    int Qx::asyncDelayed(const std::function<void()>& cb, int milliSecs)
+    {
+        return g_appPriv->postDelayed(cb, milliSecs);
+    }
+
+    void cancelDelayed(int id)
     {
-        g_appPriv->postDelayed(cb, milliSecs);
+        g_appPriv->cancelDelayed(id);
     }
 
     std::thread::id threadId()
@@ -262,4 +402,23 @@ namespace Qx
         return QxApplication::instance()->threadId();
     }
 
-}
\ No newline at end of file
+    class UIExecutor : public Executor
+    {
+    public:
+        void post(Task&& task) override
+        {
+            //std::function wants copyable callables, Task is move only
+            auto shared = std::make_shared<Task>(std::move(task));
+            g_appPriv->post([shared]() {
+                (*shared)();
+            });
+        }
+    };
+
+    Executor* executor()
+    {
+        static UIExecutor ui;
+        return &ui;
+    }
+
+}
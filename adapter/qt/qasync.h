@@ -1,6 +1,8 @@
 #pragma once
 #include <QtCore/QtCore>
 
+class Executor;
+
 class QxApplication : public QCoreApplication
 {
     Q_OBJECT;
@@ -29,7 +31,12 @@ private:
 namespace Qx
 {
     void async(const std::function<void()>& cb);
-    void asyncDelayed(const std::function<void()>& cb, int milliSecs);
+    //returns an id for cancelDelayed, cancelling a task that already ran is a no-op
+    int asyncDelayed(const std::function<void()>& cb, int milliSecs);
+    void cancelDelayed(int id);
     std::thread::id threadId();
 
+    //the ui thread as an Executor, registered as Executors "ui" while QxApplication lives
+    Executor* executor();
+
 }
\ No newline at end of file
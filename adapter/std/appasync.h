@@ -0,0 +1,148 @@
+#pragma once
+#include "thread/timerwheel.h"
+#include "thread/executors.h"
+
+//std only counterpart of adapter/ppl/appasync.h: the same pipeline operators on top of
+//Future::then, Executors and TimerWheel, so it builds anywhere C++20 does.
+//stages are continuations stored inline in the future's shared state, a chain costs
+//one shared state per stage and no std::function or shared_ptr.
+//
+//  using namespace concurrency_std;
+//  auto t = delayed(1000)
+//  | ui([] { return 42; })
+//  | io([](int v) { return readFile(v); })
+//  | delay<std::string>(100)
+//  | on("db")([](std::string s) { store(s); });
+//  t.wait();
+namespace concurrency_std
+{
+    template<class F>
+    auto asyncOn(Executor* executor, F&& func) -> Future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        Promise<R> promise;
+        Future<R> future = promise.future();
+        executor->post([promise = std::move(promise), func = std::forward<F>(func)]() mutable {
+            promise.run(func);
+        });
+        return future;
+    }
+
+    template<class F>
+    auto async(F&& func)
+    {
+        return asyncOn(Executors::pool(), std::forward<F>(func));
+    }
+
+    template<class F>
+    auto asyncOnUI(F&& func)
+    {
+        return asyncOn(Executors::ui(), std::forward<F>(func));
+    }
+
+    template<class F>
+    auto asyncOnIO(F&& func)
+    {
+        return asyncOn(Executors::io(), std::forward<F>(func));
+    }
+
+    template<class F>
+    struct ThenHolder
+    {
+        Executor* executor;
+        F func;
+    };
+
+    template<class T, class F>
+    auto operator | (Future<T>&& future, ThenHolder<F>&& holder)
+    {
+        return future.then(ExecutorRef{ holder.executor }, std::move(holder.func));
+    }
+
+    //stage factory, the executor is looked up when the stage is created
+    struct Stage_
+    {
+        Executor* (*resolve)() = nullptr;
+        Executor* executor = nullptr;
+
+        template<class F>
+        auto operator()(F&& func) const
+        {
+            return ThenHolder<std::decay_t<F>>{ resolve ? resolve() : executor, std::forward<F>(func) };
+        }
+    };
+
+    //any executor or a name registered with Executors::set
+    inline Stage_ on(Executor* executor)
+    {
+        assert(executor);
+        return Stage_{ nullptr, executor };
+    }
+
+    //a misspelt name must not post to a null executor, even without asserts
+    inline Stage_ on(const std::string& name)
+    {
+        Executor* executor = Executors::get(name);
+        if (!executor)
+        {
+            throw std::invalid_argument("no executor registered as " + name);
+        }
+        return Stage_{ nullptr, executor };
+    }
+
+    template<class R>
+    struct DelayThen
+    {
+        int timeout;
+    };
+
+    template<class R>
+    DelayThen<R> delay(int timeout)
+    {
+        return DelayThen<R>{ timeout };
+    }
+
+    inline DelayThen<void> delay(int timeout)
+    {
+        return DelayThen<void>{ timeout };
+    }
+
+    //a future completed on the pool after milliSecs
+    inline Future<void> delayed(int milliSecs)
+    {
+        Promise<void> promise;
+        Future<void> future = promise.future();
+        TimerWheel::asyncDelayed([promise = std::move(promise)]() mutable {
+            promise.setValue();
+        }, std::chrono::milliseconds(milliSecs));
+        return future;
+    }
+
+    //holds the value back for timeout milliSecs, errors pass through without delay
+    template<class R>
+    Future<R> operator | (Future<R>&& future, DelayThen<R>&& d)
+    {
+        return future.then(priv::InlineExecutor(), [timeout = d.timeout](R value) {
+            Promise<R> promise;
+            Future<R> delayedValue = promise.future();
+            TimerWheel::asyncDelayed([promise = std::move(promise), value = std::move(value)]() mutable {
+                promise.setValue(std::move(value));
+            }, std::chrono::milliseconds(timeout));
+            return delayedValue;
+        });
+    }
+
+    inline Future<void> operator | (Future<void>&& future, DelayThen<void>&& d)
+    {
+        return future.then(priv::InlineExecutor(), [timeout = d.timeout]() {
+            return delayed(timeout);
+        });
+    }
+
+    namespace
+    {
+        const auto pool = concurrency_std::Stage_{ &Executors::pool };
+        const auto ui = concurrency_std::Stage_{ &Executors::ui };
+        const auto io = concurrency_std::Stage_{ &Executors::io };
+    }
+}
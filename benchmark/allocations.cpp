@@ -0,0 +1,31 @@
+#include "stable.h"
+
+//counts every heap allocation of the benchmark binary, only linked into benchmark.pro
+namespace bench
+{
+    std::atomic<size_t>& allocations()
+    {
+        static std::atomic<size_t> count = 0;
+        return count;
+    }
+}
+
+void* operator new(size_t size)
+{
+    bench::allocations().fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
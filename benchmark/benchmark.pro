@@ -0,0 +1,15 @@
+TEMPLATE = app
+TARGET = benchmark
+CONFIG -= qt
+CONFIG += console
+
+QMAKE_CXXFLAGS += /await
+QMAKE_CXXFLAGS += /std:c++latest
+
+PRECOMPILED_HEADER = ../stable.h
+SOURCES += main.cpp
+SOURCES += allocations.cpp
+
+INCLUDEPATH += ../
+
+HEADERS += ../example/benchmark.h
@@ -0,0 +1,30 @@
+#include "stable.h"
+#include "example/benchmark.h"
+
+
+//benchmarks are slow and memory hungry, they live in their own binary instead of the demo
+int main(int /*argc*/, char* /*argv*/[])
+{
+    benchmark_workerpool();
+    benchmark_syncqueue();
+    benchmark_task();
+    benchmark_submit();
+    benchmark_parallel();
+    benchmark_burst();
+    benchmark_numa();
+    benchmark_rwlock();
+    benchmark_drain();
+    benchmark_timer();
+    benchmark_strand();
+    benchmark_coroutine();
+    benchmark_pipeline();
+    benchmark_callback();
+    benchmark_event_emit();
+    benchmark_event_storage();
+    benchmark_event_fast_delegate();
+    benchmark_event_churn();
+    benchmark_event_queued();
+    benchmark_event_combine();
+    benchmark_signal_easy();
+    return 0;
+}
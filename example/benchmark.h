@@ -0,0 +1,1389 @@
+#pragma once
+#include "../thread/workerpool.h"
+#include "../thread/boundedsyncqueue.h"
+#include "../thread/parallel.h"
+#include "../thread/rwlock.h"
+#include "../thread/timerwheel.h"
+#include "../thread/strand.h"
+#include "../thread/coroutine.h"
+#include "../adapter/std/appasync.h"
+#include "../object/event.h"
+#include "../object/flatevent.h"
+#include "../object/signal_slot_easy.h"
+#include "../trace/perftimer.h"
+
+namespace bench
+{
+    //heap allocations so far, counted by the operator new in benchmark/allocations.cpp
+    std::atomic<size_t>& allocations();
+
+    inline void waitFor(const std::atomic<int>& counter, int expected)
+    {
+        while (counter != expected)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    inline int64_t nowNanos()
+    {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    inline int64_t percentile(std::vector<int64_t>& samples, double p)
+    {
+        if (samples.empty())
+        {
+            return 0;
+        }
+        auto nth = samples.begin() + (size_t)((samples.size() - 1) * p);
+        std::nth_element(samples.begin(), nth, samples.end());
+        return *nth;
+    }
+
+    //the priority queue scheduler of the Qt adapter, with a shared cancel flag per timer
+    class HeapTimers
+    {
+        struct Entry
+        {
+            Task task;
+            std::atomic<bool> cancelled = false;
+        };
+
+        struct Item
+        {
+            std::chrono::steady_clock::time_point when;
+            std::shared_ptr<Entry> entry;
+
+            bool operator<(const Item& other) const
+            {
+                return when > other.when;
+            }
+        };
+
+        WorkerPool* pool_;
+        std::mutex lock_;
+        std::condition_variable cv_;
+        std::priority_queue<Item> queue_;
+        bool stop_ = false;
+        std::thread thread_;
+
+    public:
+        using Handle = std::shared_ptr<Entry>;
+
+        explicit HeapTimers(WorkerPool* pool)
+            : pool_(pool)
+        {
+            thread_ = std::thread([this]() {
+                std::unique_lock<std::mutex> lock(lock_);
+                while (!stop_)
+                {
+                    if (queue_.empty())
+                    {
+                        cv_.wait(lock);
+                        continue;
+                    }
+                    if (queue_.top().when > std::chrono::steady_clock::now())
+                    {
+                        cv_.wait_until(lock, queue_.top().when);
+                        continue;
+                    }
+                    auto entry = queue_.top().entry;
+                    queue_.pop();
+                    if (!entry->cancelled.exchange(true))
+                    {
+                        pool_->add(std::move(entry->task));
+                    }
+                }
+            });
+        }
+
+        ~HeapTimers()
+        {
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            thread_.join();
+        }
+
+        Handle schedule(Task&& task, std::chrono::microseconds delay)
+        {
+            auto entry = std::make_shared<Entry>();
+            entry->task = std::move(task);
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                queue_.push(Item{ std::chrono::steady_clock::now() + delay, entry });
+            }
+            cv_.notify_one();
+            return entry;
+        }
+
+        //cancelled entries stay in the heap until their time comes, fired ones count as cancelled
+        static bool cancel(const Handle& handle)
+        {
+            return !handle->cancelled.exchange(true);
+        }
+
+        size_t size()
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            return queue_.size();
+        }
+    };
+
+    //n producers push timestamps, n consumers pop them and record enqueue to dequeue latency
+    template<class Queue>
+    void runQueue(Queue& queue, const char* name, int threads, int items)
+    {
+        const int perProducer = items / threads;
+        const int total = perProducer * threads;
+        std::atomic<int> consumed = 0;
+        std::vector<std::vector<int64_t>> latencies(threads);
+        std::vector<std::thread> workers;
+
+        int64_t start = nowNanos();
+        for (int i = 0; i != threads; ++i)
+        {
+            workers.push_back(std::thread([&, i]() {
+                latencies[i].reserve(total / threads * 2);
+                int64_t stamp = 0;
+                while (consumed < total && queue.dequeue(stamp))
+                {
+                    latencies[i].push_back(nowNanos() - stamp);
+                    consumed += 1;
+                }
+            }));
+        }
+        for (int i = 0; i != threads; ++i)
+        {
+            workers.push_back(std::thread([&]() {
+                for (int j = 0; j != perProducer; ++j)
+                {
+                    queue.enqueue(nowNanos());
+                }
+            }));
+        }
+
+        waitFor(consumed, total);
+        int64_t cost = nowNanos() - start;
+        queue.stop();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+
+        std::vector<int64_t> all;
+        for (auto& samples : latencies)
+        {
+            all.insert(all.end(), samples.begin(), samples.end());
+        }
+        std::cout << "  " << name << " " << threads << "x" << threads
+            << ": " << (int64_t)total * 1000 / std::max<int64_t>(cost / 1000000, 1) << " ops/s"
+            << ", p50 " << percentile(all, 0.5) << "ns"
+            << ", p99 " << percentile(all, 0.99) << "ns" << std::endl;
+    }
+}
+
+namespace bench
+{
+    inline coro::task<int> leaf(int value)
+    {
+        co_return value;
+    }
+
+    inline coro::task<int64_t> awaitChain(int count)
+    {
+        int64_t sum = 0;
+        for (int i = 0; i != count; ++i)
+        {
+            sum += co_await leaf(i);
+        }
+        co_return sum;
+    }
+
+    inline coro::task<void> hops(WorkerPool& pool, int count)
+    {
+        for (int i = 0; i != count; ++i)
+        {
+            co_await pool.schedule();
+        }
+    }
+
+    inline coro::task<int> hopOnce(WorkerPool& pool, int value)
+    {
+        co_await pool.schedule();
+        co_return value;
+    }
+
+    inline coro::task<int64_t> fanOut(WorkerPool& pool, int count)
+    {
+        std::vector<coro::task<int>> tasks;
+        tasks.reserve(count);
+        for (int i = 0; i != count; ++i)
+        {
+            tasks.push_back(hopOnce(pool, i));
+        }
+        auto results = co_await coro::when_all(std::move(tasks));
+        co_return std::accumulate(results.begin(), results.end(), (int64_t)0);
+    }
+
+    //a callback that posts itself again, the pre coroutine way to hop threads
+    inline void repost(WorkerPool& pool, std::atomic<int>& left)
+    {
+        if (left.fetch_sub(1) > 1)
+        {
+            pool.add([&pool, &left]() {
+                repost(pool, left);
+            });
+        }
+    }
+}
+
+namespace bench
+{
+    struct CallbackCounter
+    {
+        int64_t total = 0;
+
+        void add(int value)
+        {
+            total += value;
+        }
+    };
+
+    //construct, copy and call one callback type, time and heap allocations per operation
+    template<class Fn, class MakeMember>
+    void callbackOps(const char* name, int count, MakeMember makeMember)
+    {
+        CallbackCounter counter;
+        auto run = [&](const char* op, auto body) {
+            size_t before = allocations();
+            int64_t start = nowNanos();
+            body();
+            int64_t cost = nowNanos() - start;
+            std::cout << "  " << name << " " << op << ": " << (double)cost / count << "ns"
+                << ", allocations " << (double)(allocations() - before) / count << std::endl;
+        };
+
+        auto makeLambda = [&counter](int i) {
+            return [&counter, i](int value) {
+                counter.add(value + i);
+            };
+        };
+        //FastDelegate only binds functions
+        if constexpr (std::is_constructible<Fn, decltype(makeLambda(0))>::value)
+        {
+            run("construct lambda", [&]() {
+                for (int i = 0; i != count; ++i)
+                {
+                    Fn func = makeLambda(i);
+                    func(1);
+                }
+            });
+        }
+        run("construct member", [&]() {
+            for (int i = 0; i != count; ++i)
+            {
+                Fn func = makeMember(&counter);
+                func(i);
+            }
+        });
+
+        Fn proto = makeMember(&counter);
+        run("copy            ", [&]() {
+            for (int i = 0; i != count; ++i)
+            {
+                Fn copy = proto;
+                copy(i);
+            }
+        });
+        run("call            ", [&]() {
+            for (int i = 0; i != count; ++i)
+            {
+                proto(i);
+            }
+        });
+        assert(counter.total != 0);
+    }
+}
+
+inline void benchmark_workerpool()
+{
+    const int kTasks = 200000;
+    const int kRoots = 1000;
+    const int kChildren = 200;
+
+    for (auto mode : { WorkerPool::Mode::SingleQueue, WorkerPool::Mode::WorkStealing })
+    {
+        const char* name = mode == WorkerPool::Mode::SingleQueue ? "single queue" : "work stealing";
+        std::cout << "workerpool " << name << ", threads " << std::thread::hardware_concurrency() << std::endl;
+
+        WorkerPool pool(std::thread::hardware_concurrency(), mode);
+        std::atomic<int> done = 0;
+        {
+            ConsolePerfTimer timer("  post from outside");
+            for (int i = 0; i != kTasks; ++i)
+            {
+                pool.add([&done]() {
+                    done += 1;
+                });
+            }
+            bench::waitFor(done, kTasks);
+        }
+
+        done = 0;
+        {
+            ConsolePerfTimer timer("  post from inside workers");
+            for (int i = 0; i != kRoots; ++i)
+            {
+                pool.add([&pool, &done]() {
+                    for (int j = 0; j != kChildren; ++j)
+                    {
+                        pool.add([&done]() {
+                            done += 1;
+                        });
+                    }
+                });
+            }
+            bench::waitFor(done, kRoots * kChildren);
+        }
+    }
+}
+
+inline void benchmark_syncqueue()
+{
+    const int kItems = 200000;
+
+    std::cout << "syncqueue producers x consumers" << std::endl;
+    for (int threads = 1; threads <= 32; threads *= 2)
+    {
+        {
+            SyncQueue<int64_t> queue;
+            bench::runQueue(queue, "mutex  ", threads, kItems);
+        }
+        {
+            BoundedSyncQueue<int64_t> queue(4096);
+            bench::runQueue(queue, "bounded", threads, kItems);
+        }
+    }
+}
+
+inline void benchmark_task()
+{
+    const int kTasks = 100000;
+    std::array<char, 48> payload = {};
+    std::string text = "captured by value";
+
+    auto run = [&](const char* name, auto post) {
+        WorkerPool pool(std::thread::hardware_concurrency());
+        std::atomic<int> done = 0;
+        size_t before = bench::allocations();
+        {
+            ConsolePerfTimer timer(name);
+            for (int i = 0; i != kTasks; ++i)
+            {
+                post(pool, [&done, payload, i]() {
+                    done += payload[i % payload.size()] + 1;
+                });
+            }
+            bench::waitFor(done, kTasks);
+        }
+        std::cout << "  allocations per task " << (double)(bench::allocations() - before) / kTasks << std::endl;
+    };
+
+    std::cout << "task storage, 64 byte lambda" << std::endl;
+    run("  std::function", [](WorkerPool& pool, auto&& func) {
+        std::function<void()> task = func;
+        pool.add(std::move(task));
+    });
+    run("  Task", [](WorkerPool& pool, auto&& func) {
+        pool.add(func);
+    });
+
+    //move only capture, std::function can not hold this at all
+    WorkerPool pool(1);
+    std::atomic<int> done = 0;
+    auto owned = std::make_unique<std::string>(text);
+    pool.add([&done, owned = std::move(owned)]() {
+        done += owned->empty() ? 0 : 1;
+    });
+    bench::waitFor(done, 1);
+}
+
+inline void benchmark_submit()
+{
+    const int kTasks = 10000;
+    WorkerPool pool(std::thread::hardware_concurrency());
+
+    std::cout << "fan out " << kTasks << " subtasks" << std::endl;
+    {
+        std::atomic<int> done = 0;
+        ConsolePerfTimer timer("  add one by one");
+        for (int i = 0; i != kTasks; ++i)
+        {
+            pool.add([&done]() {
+                done += 1;
+            });
+        }
+        bench::waitFor(done, kTasks);
+    }
+    {
+        std::atomic<int> done = 0;
+        ConsolePerfTimer timer("  add_bulk");
+        std::vector<Task> batch;
+        batch.reserve(kTasks);
+        for (int i = 0; i != kTasks; ++i)
+        {
+            batch.emplace_back([&done]() {
+                done += 1;
+            });
+        }
+        pool.add_bulk(std::move(batch));
+        bench::waitFor(done, kTasks);
+    }
+    {
+        ConsolePerfTimer timer("  std::promise per task");
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i != kTasks; ++i)
+        {
+            auto promise = std::make_shared<std::promise<int>>();
+            futures.push_back(promise->get_future());
+            pool.add([promise, i]() {
+                promise->set_value(i);
+            });
+        }
+        int64_t sum = 0;
+        for (auto& future : futures)
+        {
+            sum += future.get();
+        }
+        assert(sum == (int64_t)kTasks * (kTasks - 1) / 2);
+    }
+    {
+        ConsolePerfTimer timer("  submit");
+        std::vector<Future<int>> futures;
+        for (int i = 0; i != kTasks; ++i)
+        {
+            futures.push_back(pool.submit([i]() {
+                return i;
+            }));
+        }
+        int64_t sum = 0;
+        for (auto& future : futures)
+        {
+            sum += future.get();
+        }
+        assert(sum == (int64_t)kTasks * (kTasks - 1) / 2);
+    }
+}
+
+inline void benchmark_parallel(size_t maxCount = 100000000)
+{
+    WorkerPool pool(std::thread::hardware_concurrency());
+
+    for (size_t count = 1000000; count <= maxCount; count *= 10)
+    {
+        std::cout << "parallel algorithms, " << count << " elements" << std::endl;
+        std::vector<double> values(count);
+        std::mt19937 random(42);
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        for (auto& value : values)
+        {
+            value = dist(random);
+        }
+
+        {
+            ConsolePerfTimer timer("  std::for_each");
+            std::for_each(values.begin(), values.end(), [](double& v) { v = std::sqrt(v * v + 1.0); });
+        }
+        {
+            ConsolePerfTimer timer("  parallel_for_each");
+            parallel::parallel_for_each(pool, values.begin(), values.end(), [](double& v) { v = std::sqrt(v * v + 1.0); });
+        }
+
+        double serialSum = 0;
+        {
+            ConsolePerfTimer timer("  std::accumulate");
+            serialSum = std::accumulate(values.begin(), values.end(), 0.0);
+        }
+        double parallelSum = 0;
+        {
+            ConsolePerfTimer timer("  parallel_reduce");
+            parallelSum = parallel::parallel_reduce(pool, (size_t)0, count, 0.0,
+                [&values](size_t begin, size_t end, double sum) {
+                    return std::accumulate(values.begin() + begin, values.begin() + end, sum);
+                },
+                [](double a, double b) { return a + b; });
+        }
+        assert(std::abs(serialSum - parallelSum) < 1e-6 * serialSum);
+
+        std::shuffle(values.begin(), values.end(), random);
+        std::vector<double> copy = values;
+        {
+            ConsolePerfTimer timer("  std::sort");
+            std::sort(copy.begin(), copy.end());
+        }
+        {
+            ConsolePerfTimer timer("  parallel_sort");
+            parallel::parallel_sort(pool, values.begin(), values.end());
+        }
+        assert(copy == values);
+    }
+}
+
+inline void benchmark_burst()
+{
+    const int kBursts = 200;
+    const int kBurstSize = 32;
+    const unsigned int threads = std::max(2u, std::thread::hardware_concurrency());
+
+    //bursts separated by idle gaps long enough for workers to park, latency is enqueue to start
+    auto run = [&](const char* name, WorkerPool& pool) {
+        std::vector<int64_t> latencies(kBursts * kBurstSize);
+        std::atomic<int> done = 0;
+        for (int burst = 0; burst != kBursts; ++burst)
+        {
+            for (int i = 0; i != kBurstSize; ++i)
+            {
+                int64_t* slot = &latencies[burst * kBurstSize + i];
+                int64_t posted = bench::nowNanos();
+                pool.add([slot, posted, &done]() {
+                    *slot = bench::nowNanos() - posted;
+                    done += 1;
+                });
+            }
+            bench::waitFor(done, (burst + 1) * kBurstSize);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        std::cout << "  " << name << ": p50 " << bench::percentile(latencies, 0.5) / 1000
+            << "us, p99 " << bench::percentile(latencies, 0.99) / 1000 << "us"
+            << ", threads " << pool.size() << std::endl;
+    };
+
+    std::cout << "burst latency, " << kBursts << " bursts of " << kBurstSize << std::endl;
+    {
+        WorkerPool pool(threads);
+        run("park immediately", pool);
+    }
+    {
+        WorkerPool pool(threads);
+        pool.setSpinPeriod(std::chrono::milliseconds(3));
+        run("spin 3ms then park", pool);
+    }
+    {
+        WorkerPool pool(1);
+        pool.setElastic(1, threads, std::chrono::milliseconds(50));
+        pool.setSpinPeriod(std::chrono::milliseconds(3));
+        run("elastic 1..n, spin 3ms", pool);
+    }
+}
+
+inline void benchmark_numa(size_t bufferBytes = 64 << 20)
+{
+    const CpuTopology topology = CpuTopology::detect();
+    const unsigned int threads = topology.cpuCount();
+    const size_t elements = bufferBytes / sizeof(int64_t);
+    const int kPasses = 4;
+
+    std::cout << "memory bandwidth, " << topology.nodeCount() << " numa nodes, " << threads << " cpus" << std::endl;
+
+    //each buffer is first touched by a task on its node, then summed by tasks hinted to the same node
+    auto run = [&](const char* name, WorkerPool& pool) {
+        std::vector<std::vector<int64_t>> buffers(threads);
+        std::atomic<int> done = 0;
+        for (unsigned int i = 0; i != threads; ++i)
+        {
+            pool.addOnNode([&buffers, &done, i, elements]() {
+                buffers[i].assign(elements, i);
+                done += 1;
+            }, i % topology.nodeCount());
+        }
+        bench::waitFor(done, (int)threads);
+
+        std::atomic<int64_t> total = 0;
+        done = 0;
+        int64_t start = bench::nowNanos();
+        for (int pass = 0; pass != kPasses; ++pass)
+        {
+            for (unsigned int i = 0; i != threads; ++i)
+            {
+                pool.addOnNode([&buffers, &done, &total, i]() {
+                    total += std::accumulate(buffers[i].begin(), buffers[i].end(), (int64_t)0);
+                    done += 1;
+                }, i % topology.nodeCount());
+            }
+        }
+        bench::waitFor(done, (int)threads * kPasses);
+        int64_t cost = std::max<int64_t>(bench::nowNanos() - start, 1);
+
+        double bytes = (double)bufferBytes * threads * kPasses;
+        std::cout << "  " << name << ": " << bytes / cost << " GB/s" << std::endl;
+    };
+
+    {
+        WorkerPool pool(threads, WorkerPool::Mode::WorkStealing);
+        run("no placement", pool);
+    }
+    {
+        WorkerPool pool(threads, WorkerPool::Mode::WorkStealing);
+        pool.spreadOverNodes(topology);
+        run("spread over nodes", pool);
+    }
+    {
+        std::vector<unsigned int> cpus;
+        for (const auto& node : topology.nodes)
+        {
+            cpus.insert(cpus.end(), node.begin(), node.end());
+        }
+        WorkerPool pool(threads, WorkerPool::Mode::WorkStealing);
+        pool.pinWorkers(cpus, topology);
+        run("pinned to cores", pool);
+    }
+}
+
+inline void benchmark_rwlock(int maxThreads = 64)
+{
+    const int kOps = 20000;
+    struct Table
+    {
+        int64_t values[8];
+    };
+
+    std::cout << "rwlock, ops/s per thread count" << std::endl;
+    for (int readPercent : { 100, 99, 90, 50 })
+    {
+        std::cout << "  " << readPercent << "% reads" << std::endl;
+
+        auto run = [&](const char* name, auto read, auto write) {
+            std::cout << "    " << name;
+            for (int threads = 1; threads <= maxThreads; threads *= 2)
+            {
+                std::vector<std::thread> workers;
+                std::atomic<int> ready = 0;
+                int64_t start = bench::nowNanos();
+                for (int i = 0; i != threads; ++i)
+                {
+                    workers.push_back(std::thread([&, i]() {
+                        std::minstd_rand random(i + 1);
+                        ready += 1;
+                        while (ready != threads)
+                        {
+                            std::this_thread::yield();
+                        }
+                        for (int j = 0; j != kOps; ++j)
+                        {
+                            if ((int)(random() % 100) < readPercent)
+                            {
+                                read();
+                            }
+                            else
+                            {
+                                write(j);
+                            }
+                        }
+                    }));
+                }
+                for (auto& worker : workers)
+                {
+                    worker.join();
+                }
+                int64_t cost = std::max<int64_t>(bench::nowNanos() - start, 1);
+                std::cout << " " << threads << ":" << (int64_t)((double)threads * kOps * 1e9 / cost);
+            }
+            std::cout << std::endl;
+        };
+
+        Table table = {};
+        std::atomic<int64_t> sink = 0;
+        auto sum = [&]() {
+            int64_t total = 0;
+            for (auto value : table.values)
+            {
+                total += value;
+            }
+            return total;
+        };
+        auto fill = [&](int value) {
+            for (auto& slot : table.values)
+            {
+                slot = value;
+            }
+        };
+
+        auto runLock = [&](const char* name, auto& lock) {
+            run(name, [&]() {
+                std::shared_lock<std::decay_t<decltype(lock)>> guard(lock);
+                sink.fetch_add(sum(), std::memory_order_relaxed);
+            }, [&](int value) {
+                std::unique_lock<std::decay_t<decltype(lock)>> guard(lock);
+                fill(value);
+            });
+        };
+
+        {
+            std::mutex lock;
+            run("std::mutex        ", [&]() {
+                std::lock_guard<std::mutex> guard(lock);
+                sink.fetch_add(sum(), std::memory_order_relaxed);
+            }, [&](int value) {
+                std::lock_guard<std::mutex> guard(lock);
+                fill(value);
+            });
+        }
+        {
+            std::shared_mutex lock;
+            runLock("std::shared_mutex ", lock);
+        }
+        {
+            RWSpinLock lock;
+            runLock("RWSpinLock        ", lock);
+        }
+        {
+            ShardedRWLock lock;
+            runLock("ShardedRWLock     ", lock);
+        }
+        {
+            SeqLocked<Table> locked;
+            run("SeqLocked         ", [&]() {
+                Table snapshot = locked.load();
+                sink.fetch_add(snapshot.values[0], std::memory_order_relaxed);
+            }, [&](int value) {
+                locked.update([value](Table& current) {
+                    for (auto& slot : current.values)
+                    {
+                        slot = value;
+                    }
+                });
+            });
+        }
+    }
+}
+
+inline void benchmark_drain()
+{
+    const int kProducers = 2;
+    const int kItems = 500000;
+    const int total = kProducers * kItems;
+
+    //producers keep pushing while one consumer drains in batches
+    auto run = [&](const char* name, auto drain) {
+        SyncQueue<int64_t> queue;
+        std::atomic<int64_t> sum = 0;
+        std::vector<std::thread> producers;
+        size_t before = bench::allocations();
+        int64_t start = bench::nowNanos();
+        for (int i = 0; i != kProducers; ++i)
+        {
+            producers.push_back(std::thread([&queue]() {
+                for (int j = 0; j != kItems; ++j)
+                {
+                    queue.enqueue((int64_t)j);
+                }
+            }));
+        }
+
+        int consumed = 0;
+        int batches = 0;
+        while (consumed != total)
+        {
+            consumed += drain(queue, sum);
+            batches += 1;
+        }
+        int64_t cost = std::max<int64_t>(bench::nowNanos() - start, 1);
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        assert(sum == (int64_t)kProducers * kItems * (kItems - 1) / 2);
+
+        std::cout << "  " << name << ": " << (int64_t)((double)total * 1e9 / cost) << " items/s"
+            << ", " << total / batches << " items per batch"
+            << ", allocations per drain " << (double)(bench::allocations() - before) / batches << std::endl;
+    };
+
+    std::cout << "syncqueue drain, " << kProducers << " producers" << std::endl;
+    run("dequeueAll           ", [](SyncQueue<int64_t>& queue, std::atomic<int64_t>& sum) {
+        std::deque<int64_t> items;
+        queue.dequeueAll(items);
+        sum += std::accumulate(items.begin(), items.end(), (int64_t)0);
+        return (int)items.size();
+    });
+
+    //producers and consumer keep trading the same two vectors
+    std::vector<int64_t> buffer;
+    run("swapAll              ", [&buffer](SyncQueue<int64_t>& queue, std::atomic<int64_t>& sum) {
+        queue.swapAll(buffer);
+        sum += std::accumulate(buffer.begin(), buffer.end(), (int64_t)0);
+        return (int)buffer.size();
+    });
+
+    std::vector<int64_t> batch;
+    batch.reserve(256);
+    run("dequeue_up_to(256)   ", [&batch](SyncQueue<int64_t>& queue, std::atomic<int64_t>& sum) {
+        batch.clear();
+        queue.dequeue_up_to(256, batch);
+        sum += std::accumulate(batch.begin(), batch.end(), (int64_t)0);
+        return (int)batch.size();
+    });
+}
+
+inline void benchmark_timer(int timers = 200000)
+{
+    const int kMinDelayMs = 1000;
+    const int kMaxDelayMs = 2000;
+
+    //most timeouts are cancelled long before they fire
+    auto run = [&](const char* name, auto& wheel, auto cancel) {
+        std::atomic<int> fired = 0;
+        std::minstd_rand random(1);
+        std::vector<std::decay_t<decltype(wheel.schedule(Task(), std::chrono::microseconds()))>> handles;
+        handles.reserve(timers);
+
+        int64_t start = bench::nowNanos();
+        for (int i = 0; i != timers; ++i)
+        {
+            auto delay = std::chrono::milliseconds(kMinDelayMs + random() % (kMaxDelayMs - kMinDelayMs));
+            handles.push_back(wheel.schedule([&fired]() {
+                fired += 1;
+            }, delay));
+        }
+        int64_t scheduled = bench::nowNanos();
+        int cancelled = 0;
+        for (int i = 0; i != timers; ++i)
+        {
+            if (i % 10 != 0 && cancel(handles[i]))
+            {
+                cancelled += 1;
+            }
+        }
+        int64_t end = bench::nowNanos();
+        bench::waitFor(fired, timers - cancelled);
+        handles.clear();
+
+        std::cout << "  " << name << ": schedule " << (scheduled - start) / timers << "ns"
+            << ", cancel " << (end - scheduled) / std::max(cancelled, 1) << "ns"
+            << ", fired " << fired << ", still queued " << wheel.size() << std::endl;
+    };
+
+    std::cout << "timers, " << timers << " scheduled, 90% cancelled" << std::endl;
+    WorkerPool pool(2);
+    {
+        bench::HeapTimers heap(&pool);
+        run("priority queue", heap, [](const bench::HeapTimers::Handle& handle) {
+            return bench::HeapTimers::cancel(handle);
+        });
+    }
+    {
+        TimerWheel wheel(&pool);
+        run("timer wheel   ", wheel, [](const TimerWheel::Handle& handle) {
+            return handle.cancel();
+        });
+    }
+}
+
+inline void benchmark_strand(int strands = 10000, int tasksPerStrand = 20)
+{
+    const int total = strands * tasksPerStrand;
+    WorkerPool pool(std::thread::hardware_concurrency());
+
+    std::cout << "serialised components, " << strands << " x " << tasksPerStrand << " tasks" << std::endl;
+
+    //one mutex per component around the task body, pool threads block on busy components
+    {
+        struct Component
+        {
+            std::mutex lock;
+            int64_t value = 0;
+        };
+        std::vector<Component> components(strands);
+        std::atomic<int> done = 0;
+        ConsolePerfTimer timer("  mutex per component");
+        for (int i = 0; i != tasksPerStrand; ++i)
+        {
+            for (auto& component : components)
+            {
+                pool.add([&component, &done]() {
+                    std::lock_guard<std::mutex> guard(component.lock);
+                    component.value += 1;
+                    done += 1;
+                });
+            }
+        }
+        bench::waitFor(done, total);
+    }
+
+    //one strand per component, tasks also check they run in post order
+    {
+        struct Component
+        {
+            Strand strand;
+            int64_t value = 0;
+
+            explicit Component(WorkerPool* pool) : strand(pool) {}
+        };
+        std::vector<std::unique_ptr<Component>> components;
+        for (int i = 0; i != strands; ++i)
+        {
+            components.push_back(std::make_unique<Component>(&pool));
+        }
+        std::atomic<int> done = 0;
+        std::atomic<int> outOfOrder = 0;
+        {
+            ConsolePerfTimer timer("  strand per component");
+            for (int i = 0; i != tasksPerStrand; ++i)
+            {
+                for (auto& component : components)
+                {
+                    Component* target = component.get();
+                    target->strand.post([target, i, &done, &outOfOrder]() {
+                        if (target->value++ != i)
+                        {
+                            outOfOrder += 1;
+                        }
+                        done += 1;
+                    });
+                }
+            }
+            bench::waitFor(done, total);
+        }
+        std::cout << "  out of order " << outOfOrder << std::endl;
+    }
+}
+
+inline void benchmark_coroutine()
+{
+    const int kAwaits = 1000000;
+    const int kHops = 100000;
+    const int kFanOut = 10000;
+    WorkerPool pool(std::thread::hardware_concurrency());
+
+    //reports time and heap allocations per operation
+    auto run = [](const char* name, int count, auto body) {
+        size_t before = bench::allocations();
+        int64_t start = bench::nowNanos();
+        body();
+        int64_t cost = bench::nowNanos() - start;
+        std::cout << "  " << name << ": " << cost / count << "ns"
+            << ", allocations " << (double)(bench::allocations() - before) / count << std::endl;
+    };
+
+    std::cout << "coroutines, per operation" << std::endl;
+    run("co_await ready child task  ", kAwaits, [&]() {
+        int64_t sum = coro::sync_wait(bench::awaitChain(kAwaits));
+        assert(sum == (int64_t)kAwaits * (kAwaits - 1) / 2);
+        (void)sum;
+    });
+    run("co_await pool.schedule()   ", kHops, [&]() {
+        coro::sync_wait(bench::hops(pool, kHops));
+    });
+    run("callback reposting itself  ", kHops, [&]() {
+        std::atomic<int> left = kHops;
+        pool.add([&pool, &left]() {
+            bench::repost(pool, left);
+        });
+        while (left > 0)
+        {
+            std::this_thread::yield();
+        }
+    });
+    run("when_all over pool hops    ", kFanOut, [&]() {
+        int64_t sum = coro::sync_wait(bench::fanOut(pool, kFanOut));
+        assert(sum == (int64_t)kFanOut * (kFanOut - 1) / 2);
+        (void)sum;
+    });
+}
+
+inline void benchmark_pipeline(int maxDepth = 64)
+{
+    const int kRounds = 2000;
+    using namespace concurrency_std;
+
+    //one async plus depth pool stages, latency from building the chain to get() returning
+    std::cout << "pipeline latency per chain depth" << std::endl;
+    for (int depth = 1; depth <= maxDepth; depth *= 2)
+    {
+        std::vector<int64_t> samples;
+        samples.reserve(kRounds);
+        size_t before = bench::allocations();
+        for (int round = 0; round != kRounds; ++round)
+        {
+            int64_t start = bench::nowNanos();
+            Future<int> future = async([]() {
+                return 0;
+            });
+            for (int stage = 0; stage != depth; ++stage)
+            {
+                future = std::move(future) | pool([](int value) {
+                    return value + 1;
+                });
+            }
+            int result = future.get();
+            samples.push_back(bench::nowNanos() - start);
+            assert(result == depth);
+            (void)result;
+        }
+        double allocations = (double)(bench::allocations() - before) / kRounds / (depth + 1);
+        std::cout << "  depth " << depth << ": p50 " << bench::percentile(samples, 0.5) / 1000 << "us"
+            << ", p99 " << bench::percentile(samples, 0.99) / 1000 << "us"
+            << ", allocations per stage " << allocations << std::endl;
+    }
+}
+
+inline void benchmark_callback()
+{
+    const int kOps = 1000000;
+    using bench::CallbackCounter;
+
+    std::cout << "callbacks, per operation" << std::endl;
+    bench::callbackOps<std::function<void(int)>>("std::function         ", kOps, [](CallbackCounter* counter) {
+        return std::function<void(int)>([counter](int value) {
+            counter->add(value);
+        });
+    });
+    bench::callbackOps<Storm::Callback<void(int)>>("Storm::Callback       ", kOps, [](CallbackCounter* counter) {
+        return Storm::delegate(&CallbackCounter::add, counter);
+    });
+    bench::callbackOps<Storm::InlineCallback<void(int)>>("Storm::InlineCallback ", kOps, [](CallbackCounter* counter) {
+        return Storm::delegateInline(&CallbackCounter::add, counter);
+    });
+    bench::callbackOps<Storm::FastDelegate<void(int)>>("Storm::FastDelegate   ", kOps, [](CallbackCounter* counter) {
+        return Storm::fastDelegate<&CallbackCounter::add>(counter);
+    });
+}
+
+inline void benchmark_event_emit(int maxThreads = 16)
+{
+    const int kEmits = 1000000;
+    const int kSlots = 4;
+
+    //every thread emits the same event, slots only touch thread local state
+    auto run = [&](const char* name, auto& event) {
+        for (int threads = 1; threads <= maxThreads; threads *= 2)
+        {
+            std::vector<std::thread> emitters;
+            int64_t start = bench::nowNanos();
+            for (int t = 0; t != threads; ++t)
+            {
+                emitters.emplace_back([&event]() {
+                    for (int i = 0; i != kEmits; ++i)
+                    {
+                        event.emit(i);
+                    }
+                });
+            }
+            for (auto& emitter : emitters)
+            {
+                emitter.join();
+            }
+            int64_t cost = std::max<int64_t>(bench::nowNanos() - start, 1);
+            std::cout << "  " << name << " " << threads << " threads: "
+                << (int64_t)((double)kEmits * threads * 1000000000 / cost) << " emits/s" << std::endl;
+        }
+    };
+
+    auto connect = [](auto& event) {
+        for (int i = 0; i != kSlots; ++i)
+        {
+            event.add([](int value) {
+                static thread_local int64_t sum = 0;
+                sum += value;
+            });
+        }
+    };
+
+    std::cout << "event emit, " << kSlots << " slots" << std::endl;
+    Storm::Event<void(int), Storm::mt_policy> locked;
+    connect(locked);
+    run("mt_policy ", locked);
+    Storm::Event<void(int), Storm::rcu_policy> rcu;
+    connect(rcu);
+    run("rcu_policy", rcu);
+}
+
+inline void benchmark_event_storage()
+{
+    const int kSlotWork = 10000000;
+
+    //same total slot calls for every size
+    auto run = [&](const char* name, auto& event, int slots) {
+        int64_t sum = 0;
+        for (int i = 0; i != slots; ++i)
+        {
+            event.add([&sum](int value) {
+                sum += value;
+            });
+        }
+        const int emits = kSlotWork / slots;
+        int64_t start = bench::nowNanos();
+        for (int i = 0; i != emits; ++i)
+        {
+            event.emit(i);
+        }
+        int64_t cost = bench::nowNanos() - start;
+        assert(sum != 0 || emits == 1);
+        std::cout << "  " << name << " " << slots << " slots: " << (double)cost / emits << "ns per emit, "
+            << (double)cost / kSlotWork << "ns per slot" << std::endl;
+    };
+
+    std::cout << "event emit by connection storage" << std::endl;
+    for (int slots : { 1, 10, 100, 1000 })
+    {
+        Storm::Event<void(int)> shared;
+        run("Event     ", shared, slots);
+        Storm::FlatEvent<void(int)> flat;
+        run("FlatEvent ", flat, slots);
+    }
+}
+
+//the same member slots connected as a Delegate, which binds on the heap, and as a FastDelegate kept in the connection
+inline void benchmark_event_fast_delegate()
+{
+    const int kSlotWork = 10000000;
+    using bench::CallbackCounter;
+
+    auto run = [&](const char* name, int slots, auto makeSlot) {
+        std::vector<CallbackCounter> counters(slots);
+        Storm::Event<void(int)> event;
+        size_t before = bench::allocations();
+        for (auto& counter : counters)
+        {
+            event.add(makeSlot(&counter));
+        }
+        const double allocations = (double)(bench::allocations() - before) / slots;
+        const int emits = kSlotWork / slots;
+        int64_t start = bench::nowNanos();
+        for (int i = 0; i != emits; ++i)
+        {
+            event.emit(i);
+        }
+        int64_t cost = bench::nowNanos() - start;
+        assert(counters.back().total != 0 || emits == 1);
+        std::cout << "  " << name << " " << slots << " slots: " << (double)cost / emits << "ns per emit, "
+            << (double)cost / kSlotWork << "ns per slot, " << allocations << " allocations per add" << std::endl;
+    };
+
+    std::cout << "event emit, Delegate vs FastDelegate slots" << std::endl;
+    for (int slots : { 1, 10, 100, 1000 })
+    {
+        run("Delegate    ", slots, [](CallbackCounter* counter) {
+            return Storm::delegate(&CallbackCounter::add, counter);
+        });
+        run("FastDelegate", slots, [](CallbackCounter* counter) {
+            return Storm::fastDelegate<&CallbackCounter::add>(counter);
+        });
+    }
+}
+
+namespace bench
+{
+    struct ChurnListener : Storm::Trackable<>
+    {
+        int64_t sum = 0;
+
+        void onValue(int value)
+        {
+            sum += value;
+        }
+    };
+}
+
+//subscribe and unsubscribe in random order, per operation cost should not grow with the listener count
+inline void benchmark_event_churn()
+{
+    std::cout << "event subscribe/unsubscribe churn" << std::endl;
+    std::mt19937 random(42);
+    for (int listeners : { 100, 1000, 10000 })
+    {
+        Storm::Event<void(int)> event;
+        std::vector<Storm::Connection> connections;
+        connections.reserve(listeners);
+
+        int64_t start = bench::nowNanos();
+        for (int i = 0; i != listeners; ++i)
+        {
+            connections.push_back(event.add([](int) {}));
+        }
+        int64_t addCost = bench::nowNanos() - start;
+
+        std::shuffle(connections.begin(), connections.end(), random);
+        start = bench::nowNanos();
+        for (auto& connection : connections)
+        {
+            connection.disconnect();
+        }
+        int64_t disconnectCost = bench::nowNanos() - start;
+        assert(event.size() == 0);
+
+        //every listener tracks four events and is torn down in random order
+        Storm::Event<void(int)> events[4];
+        std::vector<std::unique_ptr<bench::ChurnListener>> objects;
+        for (int i = 0; i != listeners; ++i)
+        {
+            objects.emplace_back(new bench::ChurnListener());
+            for (auto& e : events)
+            {
+                e.add(&bench::ChurnListener::onValue, objects.back().get());
+            }
+        }
+        std::shuffle(objects.begin(), objects.end(), random);
+        start = bench::nowNanos();
+        objects.clear();
+        int64_t teardownCost = bench::nowNanos() - start;
+        assert(events[0].size() == 0);
+
+        std::cout << "  " << listeners << " listeners: add " << (double)addCost / listeners
+            << "ns, disconnect " << (double)disconnectCost / listeners
+            << "ns, trackable teardown " << (double)teardownCost / listeners / 4 << "ns per connection" << std::endl;
+    }
+}
+
+//state updates from a producer thread to a single consumer: one post per value vs queued connections
+inline void benchmark_event_queued()
+{
+    const int kEmits = 200000;
+    std::cout << "event queued delivery, " << kEmits << " emits" << std::endl;
+
+    WorkerPool pool(1);
+    std::string state(64, 'x');
+    std::atomic<bool> done = false;
+
+    auto wait = [&]() {
+        while (!done.load())
+        {
+            std::this_thread::yield();
+        }
+        done = false;
+    };
+
+    int64_t start = bench::nowNanos();
+    for (int i = 0; i != kEmits; ++i)
+    {
+        pool.post([&done, state, last = i + 1 == kEmits]() {
+            if (last)
+            {
+                done = true;
+            }
+        });
+    }
+    wait();
+    std::cout << "  post per value " << (double)(bench::nowNanos() - start) / kEmits << "ns per emit" << std::endl;
+
+    for (auto delivery : { Storm::Delivery::Queued, Storm::Delivery::Latest })
+    {
+        Storm::Event<void(const std::string&), Storm::mt_policy> event;
+        int64_t slotCalls = 0;
+        event.add([&](const std::string& value) {
+            slotCalls += 1;
+            //the empty string goes last, latest delivery never drops the last value
+            if (value.empty())
+            {
+                done = true;
+            }
+        }, &pool, delivery);
+
+        start = bench::nowNanos();
+        for (int i = 0; i + 1 != kEmits; ++i)
+        {
+            event.emit(state);
+        }
+        event.emit(std::string());
+        wait();
+        std::cout << (delivery == Storm::Delivery::Queued ? "  queued         " : "  latest         ")
+            << (double)(bench::nowNanos() - start) / kEmits << "ns per emit, " << slotCalls << " slot calls" << std::endl;
+    }
+}
+
+//veto chain of 300 handlers where one near the front says no
+inline void benchmark_event_combine()
+{
+    const int kEmits = 100000;
+    const int kHandlers = 300;
+    const int kVetoAt = 10;
+
+    Storm::Event<bool(int)> closing;
+    int64_t calls = 0;
+    for (int i = 0; i != kHandlers; ++i)
+    {
+        closing.add([&calls, i](int reason) {
+            calls += 1;
+            return i != kVetoAt || reason == 0;
+        });
+    }
+
+    std::cout << "event veto chain, " << kHandlers << " handlers, veto at " << kVetoAt << std::endl;
+    int64_t start = bench::nowNanos();
+    for (int i = 0; i != kEmits; ++i)
+    {
+        closing.emit(1);
+    }
+    std::cout << "  emit                " << (double)(bench::nowNanos() - start) / kEmits << "ns per emit, "
+        << calls / kEmits << " handlers run" << std::endl;
+
+    calls = 0;
+    int vetoed = 0;
+    start = bench::nowNanos();
+    for (int i = 0; i != kEmits; ++i)
+    {
+        vetoed += !closing.emitWith(Storm::combiner::AllOf(), 1);
+    }
+    assert(vetoed == kEmits);
+    std::cout << "  emitWith(AllOf)     " << (double)(bench::nowNanos() - start) / kEmits << "ns per emit, "
+        << calls / kEmits << " handlers run" << std::endl;
+}
+
+//signal_slot_esay: the list signal against the concurrent one, single threaded
+inline void benchmark_signal_easy()
+{
+    const int kSlotWork = 10000000;
+
+    auto run = [](const char* name, auto& signal, int slots) {
+        std::mt19937 random(42);
+        int64_t sum = 0;
+        std::vector<signal_slot_esay::connection> connections;
+        connections.reserve(slots);
+
+        size_t before = bench::allocations();
+        int64_t start = bench::nowNanos();
+        for (int i = 0; i != slots; ++i)
+        {
+            connections.push_back(signal.connect([&sum](int value) {
+                sum += value;
+            }));
+        }
+        int64_t connectCost = bench::nowNanos() - start;
+        double connectAllocations = (double)(bench::allocations() - before) / slots;
+
+        const int emits = kSlotWork / slots;
+        start = bench::nowNanos();
+        for (int i = 0; i != emits; ++i)
+        {
+            signal.emit(i);
+        }
+        int64_t emitCost = bench::nowNanos() - start;
+
+        std::shuffle(connections.begin(), connections.end(), random);
+        start = bench::nowNanos();
+        for (auto& connection : connections)
+        {
+            connection.disconnect();
+        }
+        int64_t disconnectCost = bench::nowNanos() - start;
+        assert(sum != 0);
+
+        std::cout << "  " << name << " " << slots << " slots: connect " << (double)connectCost / slots
+            << "ns (" << connectAllocations << " allocations), emit " << (double)emitCost / kSlotWork
+            << "ns per slot, disconnect " << (double)disconnectCost / slots << "ns" << std::endl;
+    };
+
+    std::cout << "signal_slot_esay signal" << std::endl;
+    for (int slots : { 10, 100, 1000 })
+    {
+        signal_slot_esay::signal<void(int)> list;
+        run("signal           ", list, slots);
+        signal_slot_esay::concurrent_signal<void(int)> concurrent;
+        run("concurrent_signal", concurrent, slots);
+    }
+}
@@ -3,8 +3,12 @@
 #include "../tool/throttle.h"
 #include "../object/signal_slot_easy.h"
 #include "../object/event.h"
+#include "../object/flatevent.h"
 #include "../time/datetime.h"
 #include "../thread/workerpool.h"
+#include "../thread/coroutine.h"
+#include "../thread/strand.h"
+#include "../adapter/std/appasync.h"
 #include "../object/comptr.h"
 #include "../object/copyonwrite.h"
 #include "../container/skiplist.h"
@@ -106,6 +110,16 @@ void example_snowflake()
 }
 
 
+struct FastListener : Storm::Trackable<>
+{
+    int sum = 0;
+
+    void add(int value)
+    {
+        sum += value;
+    }
+};
+
 void example_event_delegate()
 {
     using namespace Storm;
@@ -158,6 +172,309 @@ void example_event_delegate()
 
     auto callback = callback2;
     std::cout << "\n callback: " << callback(10, 10);
+
+    //a FastDelegate is stored as is, any copy of it removes the connection, a Delegate does not
+    FastListener listener;
+    Event<void(int)> event;
+    event.add(fastDelegate<&FastListener::add>(&listener));
+    event.add(fastDelegate<&FastListener::add>(&listener), &listener);
+    event(1);
+    assert(listener.sum == 2);
+    event.remove(Delegate<void(int)>());
+    event(1);
+    assert(listener.sum == 4);
+    event.remove(fastDelegate<&FastListener::add>(&listener));
+    event(1);
+    assert(listener.sum == 4);
+    assert(event.size() == 0);
+}
+
+void example_flat_event()
+{
+    using namespace Storm;
+    FlatEvent<void(int)> event;
+    std::vector<int> order;
+
+    //a slot added during emit runs from the next emit on
+    FlatEvent<void(int)>::Connection adder;
+    adder = event.add([&](int) {
+        order.push_back(1);
+        adder.disconnect();
+        event.add([&order](int) {
+            order.push_back(2);
+        });
+    });
+    event(0);
+    assert(order == std::vector<int>({ 1 }));
+    order.clear();
+    event(0);
+    assert(order == std::vector<int>({ 2 }));
+    event.removeAll();
+
+    //a slot removed during emit does not run again, even later in the same emit
+    FlatEvent<void(int)>::Connection second;
+    event.add([&](int) {
+        order.push_back(1);
+        second.disconnect();
+    });
+    second = event.add([&order](int) {
+        order.push_back(2);
+    });
+    order.clear();
+    event(0);
+    event(0);
+    assert(order == std::vector<int>({ 1, 1 }));
+    assert(!second.isConnected());
+    event.removeAll();
+
+    //removing three of four compacts the array, the survivor's handle follows its slot
+    //and a stale handle stays dead once its index is reused
+    std::vector<FlatEvent<void(int)>::Connection> conns;
+    for (auto i = 0; i != 4; ++i)
+    {
+        conns.push_back(event.add([&order, i](int) {
+            order.push_back(i);
+        }));
+    }
+    for (auto i = 0; i != 3; ++i)
+    {
+        conns[i].disconnect();
+    }
+    auto reused = event.add([&order](int) {
+        order.push_back(4);
+    });
+    assert(!conns[2].isConnected());
+    assert(!event.remove(conns[2]));
+    assert(reused.isConnected());
+    order.clear();
+    event(0);
+    assert(order == std::vector<int>({ 3, 4 }));
+    conns[3].disconnect();
+    order.clear();
+    event(0);
+    assert(order == std::vector<int>({ 4 }));
+    event.removeAll();
+
+    //removeAll during emit stops the rest of that emit and drops what it added
+    int calls = 0;
+    event.add([&](int) {
+        calls += 1;
+        event.add([&calls](int) {
+            calls += 100;
+        });
+        event.removeAll();
+    });
+    event.add([&calls](int) {
+        calls += 10;
+    });
+    event(0);
+    event(0);
+    assert(calls == 1);
+    assert(event.size() == 0);
+}
+
+
+void example_event_queued()
+{
+    using namespace Storm;
+    WorkerPool pool(4);
+    Event<void(std::string&&)> moved;
+    std::mutex lock;
+    std::vector<std::string> received;
+
+    //every queued slot takes the string by rvalue, each must get it whole
+    std::vector<Connection> conns;
+    for (auto i = 0; i != 4; ++i)
+    {
+        conns.push_back(moved.add([&](std::string&& str) {
+            std::string taken(std::move(str));
+            std::lock_guard<std::mutex> scopeLock(lock);
+            received.push_back(taken);
+        }, &pool, Delivery::BlockingQueued));
+    }
+    for (auto i = 0; i != 100; ++i)
+    {
+        moved.emit(std::string("a string too long for the small buffer"));
+    }
+    assert(received.size() == 400);
+    for (auto& str : received)
+    {
+        assert(str == "a string too long for the small buffer");
+    }
+
+    //a stopped pool refuses the drain, emit delivers on its own thread instead of leaving
+    //the connection marked as scheduled, so neither kind of emit gets stuck
+    WorkerPool stopped(1);
+    stopped.stop();
+    Event<void(int)> event;
+    int queued = 0;
+    int blocking = 0;
+    Connection queuedConn = event.add([&queued](int value) {
+        queued += value;
+    }, &stopped, Delivery::Queued);
+    Connection blockingConn = event.add([&blocking](int value) {
+        blocking += value;
+    }, &stopped, Delivery::BlockingQueued);
+    for (auto i = 0; i != 3; ++i)
+    {
+        event.emit(1);
+    }
+    assert(queued == 3);
+    assert(blocking == 3);
+}
+
+
+void example_event_rcu()
+{
+    using namespace Storm;
+
+    //a slot may destroy the very event emitting it
+    auto owned = new Event<void(int), rcu_policy>();
+    int calls = 0;
+    owned->add([&calls, owned](int) {
+        calls += 1;
+        delete owned;
+    });
+    (*owned)(1);
+    assert(calls == 1);
+
+    //connecting while other threads keep emitting
+    Event<void(int), rcu_policy> event;
+    std::atomic<bool> stop = false;
+    std::atomic<int> hits = 0;
+    std::vector<std::thread> emitters;
+    for (auto i = 0; i != 3; ++i)
+    {
+        emitters.emplace_back([&event, &stop]() {
+            while (!stop)
+            {
+                event(0);
+            }
+        });
+    }
+    std::vector<Connection> conns;
+    for (auto i = 0; i != 1000; ++i)
+    {
+        conns.push_back(event.add([&hits](int value) {
+            hits += value;
+        }));
+    }
+    stop = true;
+    for (auto& emitter : emitters)
+    {
+        emitter.join();
+    }
+    assert(event.size() == 1000);
+    event(1);
+    assert(hits == 1000);
+
+    //the last reader out frees what was retired meanwhile
+    for (auto& conn : conns)
+    {
+        conn.disconnect();
+    }
+    {
+        Rcu::ReadGuard guard;
+    }
+    assert(Rcu::retiredCount() == 0);
+}
+
+void example_concurrent_signal()
+{
+    using namespace signal_slot_esay;
+    //two threads emitting until told to stop
+    auto emitting = [](concurrent_signal<void(int)>& signal, std::atomic<bool>& stop) {
+        std::vector<std::thread> threads;
+        for (auto i = 0; i != 2; ++i)
+        {
+            threads.emplace_back([&signal, &stop]() {
+                while (!stop)
+                {
+                    signal(1);
+                }
+            });
+        }
+        return threads;
+    };
+    auto join = [](std::vector<std::thread>& threads) {
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    };
+
+    //emit racing connect, the array grows under the emits and no slot is lost
+    {
+        concurrent_signal<void(int)> signal;
+        std::atomic<int> calls = 0;
+        std::atomic<bool> stop = false;
+        auto emitters = emitting(signal, stop);
+        std::vector<connection> conns;
+        for (auto i = 0; i != 1000; ++i)
+        {
+            conns.push_back(signal.connect([&calls](int value) {
+                calls += value;
+            }));
+        }
+        stop = true;
+        join(emitters);
+        calls = 0;
+        signal(1);
+        assert(calls == 1000);
+        assert(signal.size() == 1000);
+    }
+
+    //emit racing disconnect, three of four go so the array is rebuilt more than once while half dead.
+    //once the emits are over a disconnected slot never runs again
+    {
+        concurrent_signal<void(int)> signal;
+        std::atomic<int> calls = 0;
+        std::vector<connection> conns;
+        for (auto i = 0; i != 1000; ++i)
+        {
+            conns.push_back(signal.connect([&calls](int value) {
+                calls += value;
+            }));
+        }
+        std::atomic<bool> stop = false;
+        auto emitters = emitting(signal, stop);
+        for (auto i = 0; i != 1000; ++i)
+        {
+            if (i % 4 != 0)
+            {
+                conns[i].disconnect();
+            }
+        }
+        stop = true;
+        join(emitters);
+        calls = 0;
+        signal(1);
+        assert(calls == 250);
+        assert(signal.size() == 250);
+    }
+
+    //the signal goes away while its connections are alive and being disconnected on another thread
+    for (auto round = 0; round != 100; ++round)
+    {
+        auto signal = std::make_unique<concurrent_signal<void(int)>>();
+        std::vector<connection> conns;
+        for (auto i = 0; i != 8; ++i)
+        {
+            conns.push_back(signal->connect([](int) {}));
+        }
+        std::thread disconnecting([&conns]() {
+            for (auto& conn : conns)
+            {
+                conn.disconnect();
+            }
+        });
+        signal.reset();
+        disconnecting.join();
+        for (auto& conn : conns)
+        {
+            conn.disconnect();
+        }
+    }
 }
 
 
@@ -193,6 +510,167 @@ void example_workerpool()
     std::cout << vec.size() <<"\t" << tvec.size()<<std::endl;
 }
 
+void example_workerpool_priority()
+{
+    using Priority = WorkerPool::Priority;
+    WorkerPool pool(1);
+    std::mutex lock;
+    std::vector<int> order;
+    std::atomic<int> done = 0;
+    std::atomic<bool> release = false;
+    auto record = [&](int value) {
+        return [&, value]() {
+            std::lock_guard<std::mutex> scopeLock(lock);
+            order.push_back(value);
+            done += 1;
+        };
+    };
+    auto block = [&release]() {
+        while (!release)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+    auto waitFor = [&done](int count) {
+        while (done != count)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    //higher lanes first, a task whose deadline passes in the queue never runs
+    pool.add(block, Priority::High);
+    pool.add(record(3), Priority::Background);
+    pool.add(record(2), Priority::Normal);
+    pool.add(record(1), Priority::High);
+    pool.add(record(99), Priority::High, WorkerPool::Clock::now() + std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    release = true;
+    waitFor(3);
+    pool.submit([]() {}).wait();
+    assert(order == std::vector<int>({ 1, 2, 3 }));
+    assert(pool.laneStats(Priority::High).expired == 1);
+
+    //a background task waiting past the starvation limit goes before a newer high one
+    pool.setStarvationLimit(std::chrono::milliseconds(5));
+    release = false;
+    order.clear();
+    done = 0;
+    pool.add(block, Priority::High);
+    pool.add(record(3), Priority::Background);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    pool.add(record(1), Priority::High);
+    release = true;
+    waitFor(2);
+    assert(order == std::vector<int>({ 3, 1 }));
+}
+
+void example_workerpool_stats()
+{
+#ifdef WORKERPOOL_ENABLE_STATS
+    WorkerPool pool(2);
+    std::atomic<int> done = 0;
+    for (auto i = 0; i != 100; ++i)
+    {
+        pool.add([&done]() {
+            done += 1;
+        });
+    }
+    while (done != 100)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    //a task is counted after it returns, stopping waits for the last ones
+    pool.stop();
+
+    auto stats = pool.stats();
+    uint64_t tasks = 0;
+    for (auto& worker : stats.workers)
+    {
+        assert(!worker.active);
+        assert(worker.busyNanos <= worker.aliveNanos);
+        tasks += worker.tasks;
+    }
+    assert(tasks == 100);
+    assert(stats.runTime().count == 100);
+    assert(stats.queueLatency().count == 100);
+    assert(stats.queued == 0);
+#endif
+}
+
+void example_workerpool_stopped()
+{
+    WorkerPool pool(1);
+    pool.stop();
+
+    //a stopped pool refuses instead of queueing what it would never run
+    bool ran = false;
+    Task task([&ran]() {
+        ran = true;
+    });
+    assert(!pool.tryAdd(std::move(task)));
+    task();
+    assert(ran);
+
+    //co_await schedule() then carries on the awaiting thread
+    auto hop = [](WorkerPool& target) -> coro::task<std::thread::id> {
+        co_await target.schedule();
+        co_return std::this_thread::get_id();
+    };
+    assert(coro::sync_wait(hop(pool)) == std::this_thread::get_id());
+
+    //a strand keeps its order and does not stay marked as scheduled, tasks posted from
+    //a task run after it in the same inline drain
+    Strand strand(&pool);
+    std::vector<int> order;
+    strand.post([&order, &strand]() {
+        assert(strand.runningInThisThread());
+        strand.post([&order]() {
+            order.push_back(2);
+        });
+        order.push_back(1);
+    });
+    strand.post([&order]() {
+        order.push_back(3);
+    });
+    assert(order == std::vector<int>({ 1, 2, 3 }));
+    assert(strand.pending() == 0);
+    assert(!strand.runningInThisThread());
+}
+
+void example_executors()
+{
+    using namespace concurrency_std;
+    WorkerPool worker(1);
+    std::thread::id workerId = worker.submit([]() {
+        return std::this_thread::get_id();
+    }).get();
+
+    Executors::set("example", &worker);
+    assert(Executors::get("example") == &worker);
+    auto ranOn = async([]() {
+        return 1;
+    })
+        | on("example")([](int) {
+        return std::this_thread::get_id();
+    });
+    assert(ranOn.get() == workerId);
+
+    //unregistered names are refused up front
+    Executors::set("example", nullptr);
+    assert(Executors::get("example") == nullptr);
+    bool refused = false;
+    try
+    {
+        on("example");
+    }
+    catch (const std::invalid_argument&)
+    {
+        refused = true;
+    }
+    assert(refused);
+}
+
 void example_strings()
 {
     auto res_l = utils::to_lower<std::string>("aBc");
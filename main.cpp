@@ -7,8 +7,16 @@ int main(int /*argc*/, char* /*argv*/[])
     example_throttle();
     example_snowflake();
     example_event_delegate();
+    example_flat_event();
+    example_event_queued();
+    example_event_rcu();
+    example_concurrent_signal();
     example_datetime();
     example_workerpool();
+    example_workerpool_priority();
+    example_workerpool_stats();
+    example_workerpool_stopped();
+    example_executors();
     example_strings();
     example_buffer();
     example_json();
@@ -1,16 +1,25 @@
 #pragma once
 #include <assert.h>
+#include <algorithm>
 #include <mutex>
 #include <memory>
 #include <atomic>
 #include <set>
 #include <vector>
+#include <tuple>
+#include <cstring>
+#include <future>
+#include "../thread/rcu.h"
+#include "../thread/executor.h"
 
 namespace Storm 
 {
 
     template<class>         class Callback;
     template<class T>       using Delegate = Callback<T>;
+    template<class, size_t = 48> class InlineCallback;
+    template<class T>       using InlineDelegate = InlineCallback<T>;
+    template<class>         class FastDelegate;
 
 }
 
@@ -190,7 +199,7 @@ namespace Storm
             template <typename T, typename Arg = T>
             struct EqualExists
             {
-                enum { value = !std::is_same<decltype(*(T*)(nullptr) == *(Arg*)(nullptr)), No>::value };
+                enum { value = !std::is_same<decltype(std::declval<T&>() == std::declval<Arg&>()), No>::value };
             };
         }
 
@@ -568,6 +577,376 @@ namespace Storm
     }
 }
 
+namespace Storm
+{
+    //bind() result for InlineCallback, a plain value: bound member function plus object pointer is 24 bytes
+    template <class R, bool is_mem_fun, class Fn, class ...LeftArgs>
+    struct InlineBinder
+    {
+        Fn function_;
+        std::tuple<LeftArgs...> left_args_;
+
+        template <class ...A>
+        R operator()(A&&... args)
+        {
+            return call(std::make_index_sequence<sizeof...(LeftArgs) - (is_mem_fun ? 1 : 0)>{}, std::forward<A>(args)...);
+        }
+
+        //same rules as Binder::isSameCallee
+        bool operator==(const InlineBinder& other) const
+        {
+            bool same = helper::IsSame<Fn, helper::CHECK::EqualExists<Fn>::value>::check(function_, other.function_);
+            if constexpr (is_mem_fun)
+            {
+                using Args = std::tuple<LeftArgs...>;
+                same = same && BinderObjectCheck<Args, sizeof...(LeftArgs)>::check(const_cast<Args&>(left_args_), const_cast<Args&>(other.left_args_));
+            }
+            return same;
+        }
+
+    private:
+        template <std::size_t... Is, class ...A>
+        R call(std::index_sequence<Is...>, A&&... args)
+        {
+            if constexpr (is_mem_fun)
+            {
+                using C = std::tuple_element_t<0, std::tuple<LeftArgs...>>;
+                return MethodInvokerTraits<C, R>::invoke(std::get<0>(left_args_), function_, std::get<Is + 1>(left_args_)..., std::forward<A>(args)...);
+            }
+            else
+            {
+                return function_(std::get<Is>(left_args_)..., std::forward<A>(args)...);
+            }
+        }
+    };
+
+    //Callback with value semantics: functors up to Capacity bytes are stored inline,
+    //so creating, copying and calling one never allocates and never touches a refcount.
+    //bigger (or throwing move) functors are boxed on the heap and cloned on copy.
+    //copies are independent, use isSameCallee rather than == to compare them.
+    template <class R, class ...A, size_t Capacity>
+    class InlineCallback<R(A ...), Capacity>
+    {
+        struct Ops
+        {
+            R(*invoke)(void*, A ...);
+            void(*copy)(void* dst, const void* src);
+            //move constructs dst, destroys src
+            void(*move)(void* dst, void* src);
+            void(*destroy)(void*);
+            bool(*same)(const void*, const void*);
+            //storage is copied with memcpy and needs no destroy
+            bool trivial;
+        };
+
+        template <class F>
+        static constexpr bool fitsInline = sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<F>::value;
+
+        template <class F, bool = fitsInline<F>>
+        struct Model
+        {
+            static F* get(const void* storage)
+            {
+                return std::launder(static_cast<F*>(const_cast<void*>(storage)));
+            }
+
+            template <class Fn>
+            static void construct(void* storage, Fn&& functor)
+            {
+                new (storage) F(std::forward<Fn>(functor));
+            }
+
+            static R invoke(void* storage, A ... args)
+            {
+                return (*get(storage))(std::forward<A>(args)...);
+            }
+
+            static void copy(void* dst, const void* src)
+            {
+                new (dst) F(*get(src));
+            }
+
+            static void move(void* dst, void* src)
+            {
+                new (dst) F(std::move(*get(src)));
+                get(src)->~F();
+            }
+
+            static void destroy(void* storage)
+            {
+                get(storage)->~F();
+            }
+
+            static bool same(const void* a, const void* b)
+            {
+                return helper::IsSame<F, helper::CHECK::EqualExists<F>::value>::check(*get(a), *get(b));
+            }
+
+            static constexpr Ops ops = { &invoke, &copy, &move, &destroy, &same,
+                std::is_trivially_copy_constructible<F>::value && std::is_trivially_destructible<F>::value };
+        };
+
+        //boxed, storage holds an F*
+        template <class F>
+        struct Model<F, false>
+        {
+            static F* get(const void* storage)
+            {
+                return *static_cast<F* const*>(storage);
+            }
+
+            template <class Fn>
+            static void construct(void* storage, Fn&& functor)
+            {
+                *static_cast<F**>(storage) = new F(std::forward<Fn>(functor));
+            }
+
+            static R invoke(void* storage, A ... args)
+            {
+                return (*get(storage))(std::forward<A>(args)...);
+            }
+
+            static void copy(void* dst, const void* src)
+            {
+                *static_cast<F**>(dst) = new F(*get(src));
+            }
+
+            static void move(void* dst, void* src)
+            {
+                *static_cast<F**>(dst) = get(src);
+            }
+
+            static void destroy(void* storage)
+            {
+                delete get(storage);
+            }
+
+            static bool same(const void* a, const void* b)
+            {
+                return helper::IsSame<F, helper::CHECK::EqualExists<F>::value>::check(*get(a), *get(b));
+            }
+
+            static constexpr Ops ops = { &invoke, &copy, &move, &destroy, &same, false };
+        };
+
+        const Ops* ops_ = nullptr;
+        alignas(std::max_align_t) mutable unsigned char storage_[Capacity];
+
+        void copyFrom(const InlineCallback& other)
+        {
+            if (other.ops_)
+            {
+                if (other.ops_->trivial)
+                {
+                    std::memcpy(storage_, other.storage_, Capacity);
+                }
+                else
+                {
+                    other.ops_->copy(storage_, other.storage_);
+                }
+                ops_ = other.ops_;
+            }
+        }
+
+        void moveFrom(InlineCallback& other)
+        {
+            if (other.ops_)
+            {
+                if (other.ops_->trivial)
+                {
+                    std::memcpy(storage_, other.storage_, Capacity);
+                }
+                else
+                {
+                    other.ops_->move(storage_, other.storage_);
+                }
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+
+    public:
+        InlineCallback() = default;
+
+        InlineCallback(const InlineCallback& other)
+        {
+            copyFrom(other);
+        }
+
+        InlineCallback(InlineCallback&& other) noexcept
+        {
+            moveFrom(other);
+        }
+
+        template <class Fn, typename = std::enable_if_t<!std::is_same<std::remove_cv_t<std::remove_reference_t<Fn>>, InlineCallback>::value, bool>>
+        InlineCallback(Fn&& functor)
+        {
+            using F = std::decay_t<Fn>;
+            //copying is type erased, a move only functor would only fail once copied
+            static_assert(std::is_copy_constructible<F>::value, "InlineCallback needs a copyable functor");
+            Model<F>::construct(storage_, std::forward<Fn>(functor));
+            ops_ = &Model<F>::ops;
+        }
+
+        ~InlineCallback()
+        {
+            reset();
+        }
+
+        InlineCallback& operator=(const InlineCallback& other)
+        {
+            if (this != &other)
+            {
+                reset();
+                copyFrom(other);
+            }
+            return *this;
+        }
+
+        InlineCallback& operator=(InlineCallback&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                moveFrom(other);
+            }
+            return *this;
+        }
+
+        void reset()
+        {
+            if (ops_ && !ops_->trivial)
+            {
+                ops_->destroy(storage_);
+            }
+            ops_ = nullptr;
+        }
+
+        R operator()(A ... args) const
+        {
+            assert(!isEmpty());
+            return ops_->invoke(storage_, std::forward<A>(args)...);
+        }
+
+        bool isEmpty() const
+        {
+            return ops_ == nullptr;
+        }
+
+        bool isSameCallee(const InlineCallback& other) const
+        {
+            if (ops_ && ops_ == other.ops_)
+            {
+                return ops_->same(storage_, other.storage_);
+            }
+            return false;
+        }
+    };
+
+    //bind() into an InlineCallback
+    template <class Fn, class ...A>
+    InlineCallback<typename funcion_traits_unbound_runtype<Fn, A...>::unbound_runtype> bindInline(Fn&& function, A&&... args)
+    {
+        static constexpr bool is_method = std::is_member_function_pointer<std::decay_t<Fn>>::value;
+        using UnboundRunType = typename funcion_traits_unbound_runtype<Fn, A...>::unbound_runtype;
+        using R = typename function_traits_args<UnboundRunType>::return_type;
+        using Binder = InlineBinder<R, is_method, std::decay_t<Fn>, std::decay_t<A>...>;
+        return Binder{ std::forward<Fn>(function), std::tuple<std::decay_t<A>...>(std::forward<A>(args)...) };
+    }
+
+    //the function is a template argument, so a delegate is only an object pointer and a stub
+    //generated for that function: 16 bytes, trivially copyable, called with one indirect call.
+    //two delegates are equal if they call the same function on the same object, no rtti involved.
+    //does not own or track the object. make one with fastDelegate<&C::method>(object).
+    template <class R, class ...A>
+    class FastDelegate<R(A ...)>
+    {
+        using Stub = R(*)(void*, A ...);
+
+        void* object_ = nullptr;
+        Stub stub_ = nullptr;
+
+        constexpr FastDelegate(void* object, Stub stub)
+            : object_(object), stub_(stub)
+        {
+        }
+
+        template <auto method, class C>
+        static R methodStub(void* object, A ... args)
+        {
+            return (static_cast<C*>(object)->*method)(std::forward<A>(args)...);
+        }
+
+        template <auto function>
+        static R functionStub(void*, A ... args)
+        {
+            return function(std::forward<A>(args)...);
+        }
+
+    public:
+        constexpr FastDelegate() = default;
+
+        template <auto method, class C>
+        static constexpr FastDelegate bind(C* object)
+        {
+            static_assert(std::is_invocable_r<R, decltype(method), C*, A...>::value, "method does not match the delegate signature");
+            return FastDelegate(const_cast<void*>(static_cast<const void*>(object)), &methodStub<method, C>);
+        }
+
+        template <auto function>
+        static constexpr FastDelegate bind()
+        {
+            static_assert(std::is_invocable_r<R, decltype(function), A...>::value, "function does not match the delegate signature");
+            return FastDelegate(nullptr, &functionStub<function>);
+        }
+
+        R operator()(A ... args) const
+        {
+            assert(!isEmpty());
+            return stub_(object_, std::forward<A>(args)...);
+        }
+
+        constexpr bool isEmpty() const
+        {
+            return stub_ == nullptr;
+        }
+
+        constexpr explicit operator bool() const
+        {
+            return !isEmpty();
+        }
+
+        constexpr bool operator==(const FastDelegate& other) const
+        {
+            return object_ == other.object_ && stub_ == other.stub_;
+        }
+
+        constexpr bool operator!=(const FastDelegate& other) const
+        {
+            return !operator==(other);
+        }
+    };
+
+    namespace priv
+    {
+        template <class>
+        struct method_signature;
+
+        template <class C, class R, class ...A>
+        struct method_signature<R(C::*)(A ...)>
+        {
+            using type = R(A ...);
+        };
+
+        template <class C, class R, class ...A>
+        struct method_signature<R(C::*)(A ...) const>
+        {
+            using type = R(A ...);
+        };
+    }
+}
+
 
 namespace Storm
 {
@@ -596,6 +975,50 @@ namespace Storm
     }
 }
 
+namespace Storm
+{
+    template <class R, class ...A>
+    InlineDelegate<R(A ...)> delegateInline(R(*function)(A ...))
+    {
+        return Storm::bindInline(function);
+    }
+
+    template <class C, class T, class R, class ...A>
+    InlineDelegate<R(A ...)> delegateInline(R(C::*function)(A ...), T&& object)
+    {
+        return Storm::bindInline(function, std::forward<T>(object));
+    }
+
+    template <class C, class T, class R, class ...A>
+    InlineDelegate<R(A ...)> delegateInline(R(C::*function)(A ...) const, T&& object)
+    {
+        return Storm::bindInline(function, std::forward<T>(object));
+    }
+
+    template <class F, typename = std::enable_if_t<!std::is_member_function_pointer<std::decay_t<F>>::value, bool>>
+    InlineDelegate<function_signature_t<std::decay_t<F>>> delegateInline(F&& function)
+    {
+        return Storm::bindInline(std::forward<F>(function));
+    }
+}
+
+namespace Storm
+{
+    //fastDelegate<&Widget::onClick>(widget)
+    template <auto method, class T, typename = std::enable_if_t<std::is_member_function_pointer<decltype(method)>::value, bool>>
+    constexpr FastDelegate<typename priv::method_signature<decltype(method)>::type> fastDelegate(T* object)
+    {
+        return FastDelegate<typename priv::method_signature<decltype(method)>::type>::template bind<method>(object);
+    }
+
+    //fastDelegate<&onClick>()
+    template <auto function, typename = std::enable_if_t<std::is_function<std::remove_pointer_t<decltype(function)>>::value, bool>>
+    constexpr FastDelegate<std::remove_pointer_t<decltype(function)>> fastDelegate()
+    {
+        return FastDelegate<std::remove_pointer_t<decltype(function)>>::template bind<function>();
+    }
+}
+
 
 namespace Storm
 {
@@ -608,17 +1031,32 @@ namespace Storm
             void unlock() {}
         };
 
+        //writers serialize on the mutex, emit reads an rcu published snapshot without it
+        class rcu_lock : public std::mutex
+        {
+        };
     }
 
     typedef priv::dummy_lock st_policy;
     typedef std::mutex mt_policy;
+    //for events emitted from many threads at once, emit takes no lock and touches no refcount
+    typedef priv::rcu_lock rcu_policy;
 
     typedef st_policy def_thread_policy;
 
+    //how a connection's slot is called by emit
+    enum class Delivery
+    {
+        Direct,         //in emit, on the emitting thread
+        Queued,         //posted to the connection's executor, emit returns at once
+        BlockingQueued, //posted to the connection's executor, emit waits until the slot ran
+        Latest,         //queued, a value not delivered yet is replaced by the next one
+    };
+
     template<class ThreadPolicy>
     class Trackable;
 
-    template <class, class>
+    template <class, class = def_thread_policy>
     class Event;
 
     class ConnectionConextBase;
@@ -634,28 +1072,43 @@ namespace Storm
     public:
         EventBase() = default;
         virtual ~EventBase() {}
-        virtual void connectionDisconnect(ConnectionConextBase*) = 0;
-        virtual void trackableExpired(Trackable<ThreadPolicy>* object) = 0;
+        //a connection of this event went dead, by disconnect or by its trackable expiring.
+        //returns the connections the event let go of, the caller drops them after unlocking
+        virtual std::vector<std::shared_ptr<ConnectionConextBase>> connectionDisconnect(ConnectionConextBase*) = 0;
     };
 
+    //lock order: connection context, then event, then trackable
     class ConnectionConextBase : public std::enable_shared_from_this<ConnectionConextBase>
     {
+        template<class> friend class Trackable;
+
+        //node in the trackable's intrusive list, guarded by the trackable's lock
+        ConnectionConextBase* trackPrev_ = nullptr;
+        ConnectionConextBase* trackNext_ = nullptr;
+        bool tracked_ = false;
+
     protected:
         std::atomic<bool> connected_ = true;
+        //identifies the event, never changes
+        const void* owner_;
     public:
-        ConnectionConextBase() : connected_(true) {}
+        explicit ConnectionConextBase(const void* owner) : connected_(true), owner_(owner) {}
         virtual ~ConnectionConextBase() {}
 
         virtual void disconnectSelf() = 0;
         virtual void trackableExpired() = 0;
+        //the event is going away, disconnect without calling back into it
+        virtual void detach() = 0;
         virtual void lock() = 0;
         virtual void unlock() = 0;
 
         bool isConnected() const { return connected_; }
 
+        bool belongsTo(const void* event) const { return owner_ == event; }
+
         void disconnect()
         {
-            //disconnect from event 
+            //disconnect from event
             //so this will require lock
             disconnectSelf();
             connected_ = false;
@@ -677,45 +1130,130 @@ namespace Storm
     template<class R, class ...A, class ThreadPolicy>
     class ConnectionContext<R(A...), ThreadPolicy> : public ConnectionConextBase
     {
+    public:
+        //arguments of one emit, captured once and shared by all its queued connections.
+        //a slot taking an rvalue reference moves out of its packet, so then every
+        //queued connection gets a packet of its own
+        using Packet = std::tuple<std::decay_t<A>...>;
+        static constexpr bool movesArgs = (std::is_rvalue_reference<A>::value || ...);
+        static constexpr bool is_rcu = std::is_same<ThreadPolicy, rcu_policy>::value;
+
+        //position in the event's current list, guarded by the event's lock
+        size_t index_ = 0;
+
+    private:
+        struct Pending
+        {
+            std::shared_ptr<Packet> args;
+            std::promise<void>* done;
+        };
+
+        //queued connections only, filled by emit and drained on the executor
+        struct Queue
+        {
+            Queue(Executor* e, Delivery d)
+                : executor(e), delivery(d)
+            {
+
+            }
+
+            Executor* executor;
+            Delivery delivery;
+            std::mutex lock;
+            std::vector<Pending> pending;
+            //a drain task is posted or running, at most one per connection so slots run in order
+            bool scheduled = false;
+        };
+
         EventBase<ThreadPolicy>* event_;
         Delegate<R(A...)> delegate_;
+        //kept inline instead of in delegate_, which stays empty then
+        FastDelegate<R(A...)> fast_;
         Trackable<ThreadPolicy>* contextObject_;
         ThreadPolicy lock_;
+        std::unique_ptr<Queue> queue_;
+
+        void release()
+        {
+            event_ = nullptr;
+            if (contextObject_)
+            {
+                contextObject_->connectionRemoved(this);
+                contextObject_ = nullptr;
+            }
+        }
+
+        //rcu_policy: emit may still be calling the slot, its captures go once no reader can
+        struct DelegateRelease
+        {
+            std::shared_ptr<ConnectionContext> conn;
+
+            ~DelegateRelease()
+            {
+                Delegate<R(A...)> dropped(std::move(conn->delegate_));
+            }
+        };
+
+        void releaseDelegate()
+        {
+            if constexpr (is_rcu)
+            {
+                Rcu::retire(new DelegateRelease{ std::static_pointer_cast<ConnectionContext>(shared_from_this()) });
+            }
+        }
+
     public:
         ConnectionContext(EventBase<ThreadPolicy>* e, const Delegate<R(A...)>& d, Trackable<ThreadPolicy>* t)
-            : event_(e), delegate_(d), contextObject_(t)
+            : ConnectionConextBase(e), event_(e), delegate_(d), contextObject_(t)
         {
 
         }
 
         ConnectionContext(EventBase<ThreadPolicy>* e, Delegate<R(A...)>&& d, Trackable<ThreadPolicy>* t)
-            : event_(e), delegate_(std::move(d)), contextObject_(t)
+            : ConnectionConextBase(e), event_(e), delegate_(std::move(d)), contextObject_(t)
+        {
+
+        }
+
+        ConnectionContext(EventBase<ThreadPolicy>* e, const FastDelegate<R(A...)>& d, Trackable<ThreadPolicy>* t)
+            : ConnectionConextBase(e), event_(e), fast_(d), contextObject_(t)
         {
 
         }
 
         void disconnectSelf() override
         {
-            std::lock_guard<ConnectionContext> lock(*this);
-            if (isConnected())
+            std::vector<std::shared_ptr<ConnectionConextBase>> released;
             {
+                std::lock_guard<ConnectionContext> lock(*this);
+                if (!isConnected())
+                {
+                    return;
+                }
                 nolockDisconnected();
-                event_->connectionDisconnect(this);
-                event_ = nullptr;
-                contextObject_ = nullptr;
+                released = event_->connectionDisconnect(this);
+                release();
             }
+            releaseDelegate();
         }
 
         void trackableExpired() override
         {
-            std::lock_guard<ConnectionContext> lock(*this);
-            if (isConnected())
+            disconnectSelf();
+        }
+
+        void detach() override
+        {
             {
+                std::lock_guard<ConnectionContext> lock(*this);
+                if (!isConnected())
+                {
+                    return;
+                }
                 nolockDisconnected();
-                event_->trackableExpired(contextObject_);
-                event_ = nullptr;
-                contextObject_ = nullptr;
+                release();
             }
+            releaseDelegate();
         }
 
         void lock() override
@@ -728,29 +1266,190 @@ namespace Storm
             lock_.unlock();
         }
 
-        void invoke(A ...args)
+        //before the connection is published
+        void queueTo(Executor* executor, Delivery delivery)
+        {
+            if (delivery != Delivery::Direct)
+            {
+                assert(executor);
+                queue_.reset(new Queue(executor, delivery));
+            }
+        }
+
+        bool isQueued() const
+        {
+            return queue_ != nullptr;
+        }
+
+        //direct connections, for combiners
+        R call(arg_traits_t<A> ...args)
+        {
+            return callSlot(std::forward<arg_traits_t<A>>(args)...);
+        }
+
+        void invoke(std::shared_ptr<Packet>& packet, arg_traits_t<A> ...args)
+        {
+            // here we don't need lock
+            if (!isConnected())
+            {
+                return;
+            }
+            if (!queue_)
+            {
+                callSlot(std::forward<arg_traits_t<A>>(args)...);
+                return;
+            }
+            if constexpr (movesArgs && std::is_constructible<Packet, const std::decay_t<A>&...>::value)
+            {
+                //copied, the packet of another connection may be moved from on another thread
+                enqueue(std::make_shared<Packet>(args...));
+            }
+            else if constexpr (movesArgs && std::is_constructible<Packet, arg_traits_t<A>...>::value)
+            {
+                //move only, it reaches the first queued connection like it would a direct slot
+                enqueue(std::make_shared<Packet>(std::forward<arg_traits_t<A>>(args)...));
+            }
+            else if constexpr (std::is_constructible<Packet, arg_traits_t<A>...>::value)
+            {
+                if (!packet)
+                {
+                    //the first queued connection captures the arguments for the rest
+                    packet = std::make_shared<Packet>(std::forward<arg_traits_t<A>>(args)...);
+                }
+                enqueue(packet);
+            }
+        }
+
+        //the event's lock keeps a connected context from being released meanwhile
+        auto getDelegate() const
+        {
+            return delegate_;
+        }
+
+        const FastDelegate<R(A...)>& getFastDelegate() const
+        {
+            return fast_;
+        }
+
+        Trackable<ThreadPolicy>* getTrackable()
+        {
+            std::lock_guard<ConnectionContext> lock(*this);
+            return contextObject_;
+        }
+
+        Trackable<ThreadPolicy>* nolockGetTrackable() const
+        {
+            return contextObject_;
+        }
+
+    private:
+        template<class ...Args>
+        R callSlot(Args&& ...args)
+        {
+            if (!fast_.isEmpty())
+            {
+                return fast_(std::forward<Args>(args)...);
+            }
+            return delegate_(std::forward<Args>(args)...);
+        }
+
+        //BlockingQueued must not be emitted on the executor's own thread
+        void enqueue(const std::shared_ptr<Packet>& packet)
+        {
+            Queue& queue = *queue_;
+            std::promise<void> done;
+            const bool blocking = queue.delivery == Delivery::BlockingQueued;
+            bool post = false;
+            {
+                std::lock_guard<std::mutex> lock(queue.lock);
+                if (queue.delivery == Delivery::Latest && !queue.pending.empty())
+                {
+                    queue.pending.back().args = packet;
+                }
+                else
+                {
+                    queue.pending.push_back(Pending{ packet, blocking ? &done : nullptr });
+                }
+                post = !queue.scheduled;
+                queue.scheduled = true;
+            }
+            if (post && !schedule())
+            {
+                drain();
+            }
+            if (blocking)
+            {
+                done.get_future().wait();
+            }
+        }
+
+        //false when the executor refused the drain (e.g. a stopped pool) or threw while posting it,
+        //scheduled stays set then and the caller has to drain on its own thread, or no emit would post again
+        bool schedule()
         {
-            // here we don't need lock
-            if (isConnected())
+            auto self = std::static_pointer_cast<ConnectionContext>(shared_from_this());
+            try
+            {
+                return queue_->executor->tryPost([self]() {
+                    self->drain();
+                });
+            }
+            catch (...)
             {
-                delegate_(std::forward<A>(args)...);
+                return false;
             }
         }
 
-        auto getDelegate() const
+        //runs everything queued so far as one batch, emits meanwhile go to the next one
+        void drain()
         {
-            return delegate_;
-        }
+            Queue& queue = *queue_;
+            //rcu_policy: a disconnect releases the slot once this section is over
+            std::optional<Rcu::ReadGuard> reading;
+            if constexpr (is_rcu)
+            {
+                reading.emplace();
+            }
+            std::vector<Pending> batch;
+            for (;;)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(queue.lock);
+                    batch.clear();
+                    batch.swap(queue.pending);
+                }
+                for (auto& pending : batch)
+                {
+                    if (isConnected())
+                    {
+                        deliver(*pending.args, std::index_sequence_for<A...>());
+                    }
+                    if (pending.done)
+                    {
+                        pending.done->set_value();
+                    }
+                }
 
-        Trackable<ThreadPolicy>* getTrackable()
-        {
-            std::lock_guard<ConnectionContext> lock(*this);
-            return contextObject_;
+                bool more = false;
+                {
+                    std::lock_guard<std::mutex> lock(queue.lock);
+                    more = !queue.pending.empty();
+                    queue.scheduled = more;
+                }
+                //go to the back of the executor instead of starving what else it runs,
+                //keep going here only when it refuses
+                if (!more || schedule())
+                {
+                    return;
+                }
+            }
         }
 
-        Trackable<ThreadPolicy>* nolockGetTrackable() const
+        //a shared packet feeds several slots, only a packet of this connection alone is moved from
+        template<size_t ...I>
+        void deliver(Packet& args, std::index_sequence<I...>)
         {
-            return contextObject_;
+            callSlot(static_cast<std::conditional_t<std::is_rvalue_reference<A>::value, A, std::decay_t<A>&>>(std::get<I>(args))...);
         }
     };
 
@@ -775,13 +1474,14 @@ namespace Storm
 
     };
 
+    //connections are linked into the trackable itself, adding and removing one is O(1)
     template<class ThreadPolicy = def_thread_policy>
     class Trackable
     {
-        Trackable(const Trackable &) = delete; 
+        Trackable(const Trackable &) = delete;
         Trackable &operator=(const Trackable &) = delete;
         ThreadPolicy trackableLock_;
-        std::set<std::shared_ptr<ConnectionConextBase>> connections_;
+        ConnectionConextBase* connections_ = nullptr;
     public:
         Trackable() = default;
         virtual ~Trackable()
@@ -789,258 +1489,608 @@ namespace Storm
             removeAll();
         }
 
-        void connectionAdded(const std::shared_ptr<ConnectionConextBase> & conn)
+        void connectionAdded(ConnectionConextBase* conn)
+        {
+            std::lock_guard<ThreadPolicy> lock(trackableLock_);
+            conn->trackPrev_ = nullptr;
+            conn->trackNext_ = connections_;
+            if (connections_)
+            {
+                connections_->trackPrev_ = conn;
+            }
+            connections_ = conn;
+            conn->tracked_ = true;
+        }
+
+        void connectionRemoved(ConnectionConextBase* conn)
         {
             std::lock_guard<ThreadPolicy> lock(trackableLock_);
-            connections_.insert(conn);
+            unlink(conn);
         }
 
-        void connectionRemoved(const std::shared_ptr<ConnectionConextBase> & conn)
+        //this trackable's connections to one event
+        std::vector<std::shared_ptr<ConnectionConextBase>> connectionsOf(const void* event)
         {
+            std::vector<std::shared_ptr<ConnectionConextBase>> result;
             std::lock_guard<ThreadPolicy> lock(trackableLock_);
-            auto it = connections_.find(conn);
-            if (it != connections_.end())
+            for (ConnectionConextBase* conn = connections_; conn; conn = conn->trackNext_)
             {
-                connections_.erase(it);
+                if (conn->belongsTo(event))
+                {
+                    if (auto shared = conn->weak_from_this().lock())
+                    {
+                        result.push_back(std::move(shared));
+                    }
+                }
             }
+            return result;
         }
 
         void removeAll()
         {
-            std::lock_guard<ThreadPolicy> lock(trackableLock_);
-            for (auto it = connections_.begin(); it != connections_.end(); ++it)
+            while (true)
             {
-                (*it)->trackableExpired();
+                std::shared_ptr<ConnectionConextBase> conn;
+                {
+                    std::lock_guard<ThreadPolicy> lock(trackableLock_);
+                    if (!connections_)
+                    {
+                        break;
+                    }
+                    conn = connections_->weak_from_this().lock();
+                    unlink(connections_);
+                }
+                //expire outside our lock, the connection locks itself and its event first
+                if (conn)
+                {
+                    conn->trackableExpired();
+                }
             }
-            connections_.clear();
         }
 
+    private:
+        void unlink(ConnectionConextBase* conn)
+        {
+            if (!conn->tracked_)
+            {
+                return;
+            }
+            if (conn->trackPrev_)
+            {
+                conn->trackPrev_->trackNext_ = conn->trackNext_;
+            }
+            else
+            {
+                connections_ = conn->trackNext_;
+            }
+            if (conn->trackNext_)
+            {
+                conn->trackNext_->trackPrev_ = conn->trackPrev_;
+            }
+            conn->trackPrev_ = conn->trackNext_ = nullptr;
+            conn->tracked_ = false;
+        }
     };
 
     template <class R, class ...A, class ThreadPolicy>
     class Event<R(A ...), ThreadPolicy> : public EventBase<ThreadPolicy>
     {
-        using Delegate = Delegate<R(A ...)>;
-        using ConnectionContext = ConnectionContext<R(A ...), ThreadPolicy>;
-        std::shared_ptr<std::vector<std::shared_ptr<ConnectionContext>>> connections_;
+        using DelegateType = Delegate<R(A ...)>;
+        using FastDelegateType = FastDelegate<R(A ...)>;
+        using Context = ConnectionContext<R(A ...), ThreadPolicy>;
+        using Connections = std::vector<std::shared_ptr<Context>>;
+        using Packet = typename Context::Packet;
+        using Released = std::vector<std::shared_ptr<ConnectionConextBase>>;
+        static constexpr bool is_rcu = std::is_same<ThreadPolicy, rcu_policy>::value;
+
+        std::shared_ptr<Connections> connections_;
         ThreadPolicy lock_;
+        //disconnected contexts still in connections_, emit skips them until compaction
+        size_t dead_ = 0;
+        //not rcu_policy: indexes of dead contexts left in place while an emit shared the list,
+        //the next change or emit that has it alone empties their entries
+        std::vector<size_t> unreleased_;
+        //rcu_policy: the version emit reads, and the one it replaced until that is retired
+        std::atomic<Connections*> published_ = nullptr;
+        std::shared_ptr<Connections> stale_;
 
         void compactConnections()
         {
             //make sure operation on connections is safe
-            if (!connections_.unique())
+            if constexpr (is_rcu)
+            {
+                //readers may be walking the published version, change a copy
+                if (connections_.get() == published_.load(std::memory_order_relaxed))
+                {
+                    stale_ = connections_;
+                    connections_.reset(new Connections(*connections_));
+                }
+            }
+            else if (connections_.use_count() != 1)
+            {
+                connections_.reset(new Connections(*connections_));
+            }
+            else
+            {
+                //use_count is a relaxed load, order our writes after the last emit's reads
+                std::atomic_thread_fence(std::memory_order_acquire);
+            }
+        }
+
+        //makes a change visible to emit, call at the end of every change under lock_
+        void publish()
+        {
+            if constexpr (is_rcu)
+            {
+                published_.store(connections_.get(), std::memory_order_release);
+                if (stale_)
+                {
+                    Rcu::retire(new std::shared_ptr<Connections>(std::move(stale_)));
+                }
+            }
+        }
+
+        //not rcu_policy: a dead context's entry can go as soon as no emit walks this list,
+        //one still walking an older list holds the context itself
+        void releaseUnreleased(Released& released)
+        {
+            if (unreleased_.empty() || connections_.use_count() != 1)
+            {
+                return;
+            }
+            //use_count is a relaxed load, order our writes after the last emit's reads
+            std::atomic_thread_fence(std::memory_order_acquire);
+            for (size_t index : unreleased_)
+            {
+                if (index < connections_->size())
+                {
+                    auto& conn = (*connections_)[index];
+                    if (conn && !conn->isConnected())
+                    {
+                        released.push_back(std::move(conn));
+                    }
+                }
+            }
+            unreleased_.clear();
+        }
+
+        //drops dead contexts once they make up half of the list, so each disconnect is O(1) amortised
+        void collectDead(Released& released)
+        {
+            if (dead_ <= connections_->size() / 2)
+            {
+                return;
+            }
+            auto isDead = [](const std::shared_ptr<Context>& conn) {
+                return !conn || !conn->isConnected();
+            };
+            if constexpr (is_rcu)
+            {
+                //copy only the live ones
+                if (connections_.get() == published_.load(std::memory_order_relaxed))
+                {
+                    auto live = std::make_shared<Connections>();
+                    live->reserve(connections_->size());
+                    for (auto& conn : *connections_)
+                    {
+                        if (!isDead(conn))
+                        {
+                            live->push_back(conn);
+                        }
+                    }
+                    stale_ = std::move(connections_);
+                    connections_ = std::move(live);
+                }
+            }
+            else
             {
-                connections_.reset(new std::vector<std::shared_ptr<ConnectionContext>>(*connections_));
+                compactConnections();
+            }
+            if constexpr (is_rcu)
+            {
+                connections_->erase(std::remove_if(connections_->begin(), connections_->end(), isDead), connections_->end());
+            }
+            else
+            {
+                //handed out to be dropped unlocked, renumbering the live ones
+                size_t live = 0;
+                for (auto& conn : *connections_)
+                {
+                    if (isDead(conn))
+                    {
+                        if (conn)
+                        {
+                            released.push_back(std::move(conn));
+                        }
+                    }
+                    else
+                    {
+                        conn->index_ = live;
+                        (*connections_)[live++] = std::move(conn);
+                    }
+                }
+                connections_->resize(live);
+                unreleased_.clear();
             }
+            dead_ = 0;
+            publish();
         }
 
-        Connection addConnection(const std::shared_ptr<ConnectionContext>& conn, Trackable<ThreadPolicy>* trackable = nullptr)
+        Connection addConnection(const std::shared_ptr<Context>& conn, Trackable<ThreadPolicy>* trackable = nullptr)
         {
             compactConnections();
 
+            conn->index_ = connections_->size();
             connections_->emplace_back(conn);
+            publish();
             if (trackable)
             {
-                trackable->connectionAdded(conn);
+                trackable->connectionAdded(conn.get());
             }
             return Connection(conn);
         }
 
-        void connectionDisconnect(ConnectionConextBase* conn) override
+        Connection addQueued(DelegateType&& delegate, Trackable<ThreadPolicy>* object, Executor* executor, Delivery delivery)
         {
+            static_assert(std::is_constructible<Packet, arg_traits_t<A>...>::value, "queued delivery needs copyable or rvalue arguments");
+            auto conn = std::make_shared<Context>(this, std::move(delegate), object);
+            conn->queueTo(executor, delivery);
             std::lock_guard<ThreadPolicy> lock(lock_);
-            compactConnections();
+            return addConnection(conn, object);
+        }
 
-            auto it = connections_->begin();
-            for (; it != connections_->end();)
+        //matches are disconnected outside the event's lock, disconnect takes it again
+        template<class Match>
+        void removeIf(Match&& match)
+        {
+            std::vector<std::shared_ptr<Context>> matches;
             {
-                if ((*it).get() == conn)
+                std::lock_guard<ThreadPolicy> lock(lock_);
+                for (auto& conn : *connections_)
                 {
-                    auto conn = *it;
-                    auto object = conn->nolockGetTrackable();
-                    connections_->erase(it);
-                    if (object)
+                    if (conn && conn->isConnected() && match(*conn))
                     {
-                        object->connectionRemoved(conn);
+                        matches.push_back(conn);
                     }
-                    return;
-                }
-                else
-                {
-                    ++it;
                 }
             }
+            for (auto& conn : matches)
+            {
+                conn->disconnect();
+            }
         }
 
-        void trackableExpired(Trackable<ThreadPolicy>* object) override
+        //called by the context with its own lock held
+        Released connectionDisconnect(ConnectionConextBase* conn) override
         {
+            Released released;
             std::lock_guard<ThreadPolicy> lock(lock_);
-            compactConnections();
-
-            auto it = connections_->begin();
-            for (; it != connections_->end();)
+            dead_ += 1;
+            if constexpr (!is_rcu)
             {
-                if ((*it)->nolockGetTrackable() == object)
-                {
-                    auto conn = *it;
-                    it = connections_->erase(it);
-                    continue;
-                }
-                else
-                {
-                    ++it;
-                }
+                unreleased_.push_back(static_cast<Context*>(conn)->index_);
+                releaseUnreleased(released);
             }
+            collectDead(released);
+            return released;
         }
 
     public:
-        Event() : connections_(std::make_shared<std::vector<std::shared_ptr<ConnectionContext>>>())
+        Event() : connections_(std::make_shared<Connections>())
         {
-
+            publish();
         }
 
         ~Event()
         {
             removeAll();
+            if constexpr (is_rcu)
+            {
+                //a slot of this very event may be destroying it
+                published_.store(nullptr, std::memory_order_relaxed);
+                Rcu::retire(new std::shared_ptr<Connections>(std::move(connections_)));
+            }
         }
 
-        Connection add(Delegate&& delegate)
+        Connection add(DelegateType&& delegate)
         {
             std::lock_guard<ThreadPolicy> lock(lock_);
-            return addConnection(std::make_shared<ConnectionContext>(this, std::move(delegate), nullptr));
+            return addConnection(std::make_shared<Context>(this, std::move(delegate), nullptr));
         }
 
-        Connection add(const Delegate& delegate)
+        Connection add(const DelegateType& delegate)
         {
             std::lock_guard<ThreadPolicy> lock(lock_);
-            return addConnection(std::make_shared<ConnectionContext>(this, delegate, nullptr));
+            return addConnection(std::make_shared<Context>(this, delegate, nullptr));
         }
 
         template<class C, class O, typename = std::enable_if_t<std::is_base_of<Trackable<ThreadPolicy>, std::remove_cv_t<std::remove_reference_t<O>>>::value, bool>>
         Connection add(R(C::*function)(A ...), O* object)
         {
             std::lock_guard<ThreadPolicy> lock(lock_);
-            return addConnection(std::make_shared<ConnectionContext>(this, Storm::delegate(function, object), object), object);
+            return addConnection(std::make_shared<Context>(this, Storm::delegate(function, object), object), object);
         }
 
         template<class O, typename = std::enable_if_t<std::is_base_of<Trackable<ThreadPolicy>, std::remove_cv_t<std::remove_reference_t<O>>>::value, bool>>
-        Connection add(const Delegate& delegate, O* object)
+        Connection add(const DelegateType& delegate, O* object)
         {
             std::lock_guard<ThreadPolicy> lock(lock_);
-            return addConnection(std::make_shared<ConnectionContext>(this, delegate, object), object);
+            return addConnection(std::make_shared<Context>(this, delegate, object), object);
         }
 
         template<class O, typename = std::enable_if_t<std::is_base_of<Trackable<ThreadPolicy>, std::remove_cv_t<std::remove_reference_t<O>>>::value, bool>>
-        Connection add(Delegate&& delegate, O* object)
+        Connection add(DelegateType&& delegate, O* object)
         {
             std::lock_guard<ThreadPolicy> lock(lock_);
-            return addConnection(std::make_shared<ConnectionContext>(this, std::move(delegate), object), object);
+            return addConnection(std::make_shared<Context>(this, std::move(delegate), object), object);
         }
 
-        void remove(Trackable<ThreadPolicy>* object)
+        //stored in the connection as is, no binder on the heap: add(fastDelegate<&C::method>(object))
+        Connection add(const FastDelegateType& delegate)
         {
+            assert(!delegate.isEmpty());
             std::lock_guard<ThreadPolicy> lock(lock_);
-            compactConnections();
-
-            auto it = connections_->begin();
-            for (; it != connections_->end();)
-            {
-                if ((*it)->getTrackable() == object)
-                {
-                    auto conn = *it;
-                    conn->disconnected();
-                    it = connections_->erase(it);
-                    object->connectionRemoved(conn);
-                    continue;
-                }
-                else
-                {
-                    ++it;
-                }
-            }
+            return addConnection(std::make_shared<Context>(this, delegate, nullptr));
         }
 
-        void remove(const Delegate& delegate)
+        template<class O, typename = std::enable_if_t<std::is_base_of<Trackable<ThreadPolicy>, std::remove_cv_t<std::remove_reference_t<O>>>::value, bool>>
+        Connection add(const FastDelegateType& delegate, O* object)
         {
+            assert(!delegate.isEmpty());
             std::lock_guard<ThreadPolicy> lock(lock_);
-            compactConnections();
+            return addConnection(std::make_shared<Context>(this, delegate, object), object);
+        }
+
+        //the slot runs on executor, e.g. a WorkerPool or Qx::executor(), emits are handed over in batches
+        Connection add(DelegateType delegate, Executor* executor, Delivery delivery = Delivery::Queued)
+        {
+            return addQueued(std::move(delegate), nullptr, executor, delivery);
+        }
+
+        template<class C, class O, typename = std::enable_if_t<std::is_base_of<Trackable<ThreadPolicy>, std::remove_cv_t<std::remove_reference_t<O>>>::value, bool>>
+        Connection add(R(C::*function)(A ...), O* object, Executor* executor, Delivery delivery = Delivery::Queued)
+        {
+            return addQueued(Storm::delegate(function, object), object, executor, delivery);
+        }
+
+        template<class O, typename = std::enable_if_t<std::is_base_of<Trackable<ThreadPolicy>, std::remove_cv_t<std::remove_reference_t<O>>>::value, bool>>
+        Connection add(DelegateType delegate, O* object, Executor* executor, Delivery delivery = Delivery::Queued)
+        {
+            return addQueued(std::move(delegate), object, executor, delivery);
+        }
 
-            auto it = connections_->begin();
-            for (; it != connections_->end();)
+        //walks the object's own connections, not ours
+        void remove(Trackable<ThreadPolicy>* object)
+        {
+            for (auto& conn : object->connectionsOf(this))
             {
-                if ((*it)->getDelegate() == delegate)
-                {
-                    auto conn = *it;
-                    auto object = conn->getTrackable();
-                    conn->disconnected();
-                    it = connections_->erase(it);
-                    if (object)
-                    {
-                        object->connectionRemoved(conn);
-                    }
-                    continue;
-                }
-                else
-                {
-                    ++it;
-                }
+                conn->disconnect();
             }
         }
 
-        void removeAll()
+        void remove(const DelegateType& delegate)
         {
-            std::lock_guard<ThreadPolicy> lock(lock_);
+            removeIf([&delegate](const Context& conn) {
+                return conn.getFastDelegate().isEmpty() && conn.getDelegate() == delegate;
+            });
+        }
+
+        //every connection calling the same function on the same object, a copy of the delegate will do
+        void remove(const FastDelegateType& delegate)
+        {
+            removeIf([&delegate](const Context& conn) {
+                return conn.getFastDelegate() == delegate;
+            });
+        }
 
-            for (auto it = connections_->begin(); it != connections_->end(); ++it)
+        void removeAll()
+        {
+            std::shared_ptr<Connections> connections;
+            {
+                std::lock_guard<ThreadPolicy> lock(lock_);
+                if constexpr (is_rcu)
+                {
+                    stale_ = connections_;
+                }
+                connections = std::move(connections_);
+                connections_ = std::make_shared<Connections>();
+                dead_ = 0;
+                unreleased_.clear();
+                publish();
+            }
+            for (auto& conn : *connections)
             {
-                auto conn = *it;
-                conn->disconnected();
-                auto object = (*it)->getTrackable();
-                if (object)
+                if (conn)
                 {
-                    object->connectionRemoved(conn);
+                    conn->detach();
                 }
             }
-            connections_->clear();
         }
 
-        void operator +=(const Delegate& delegate)
+        void operator +=(const DelegateType& delegate)
         {
             add(delegate);
         }
 
-        void operator +=(Delegate&& delegate)
+        void operator +=(DelegateType&& delegate)
         {
             add(std::move(delegate));
         }
 
-        void operator -=(const Delegate& delegate)
+        void operator -=(const DelegateType& delegate)
         {
             remove(delegate);
         }
 
+        //live connections
+        size_t size()
+        {
+            std::lock_guard<ThreadPolicy> lock(lock_);
+            //a disconnect racing with removeAll may count a context that is already gone
+            return connections_->size() > dead_ ? connections_->size() - dead_ : 0;
+        }
+
         void emit(arg_traits_t<A>...args)
         {
-            std::shared_ptr<std::vector<std::shared_ptr<ConnectionContext>>> connections;
-            {
-                std::lock_guard<ThreadPolicy> lock(lock_);
-                connections = connections_;
-            }
-            for (auto conn : *connections)
-            {
-                conn->invoke(arg_traits_t<A>(args)...);
-            }
+            //queued slots share one packet, made by the first of them
+            std::shared_ptr<Packet> packet;
+            visit([&](const std::shared_ptr<Context>& conn) {
+                conn->invoke(packet, arg_traits_t<A>(args)...);
+                return true;
+            });
+        }
+
+        //emit that feeds direct slots' results to combiner until it has its answer,
+        //the remaining slots do not run. queued slots run but are not combined.
+        //  bool allowed = closing.emitWith(Storm::combiner::AllOf(), window);
+        template<class Combiner>
+        decltype(auto) emitWith(Combiner&& combiner, arg_traits_t<A>...args)
+        {
+            static_assert(!std::is_void<R>::value, "void slots have nothing to combine");
+            std::shared_ptr<Packet> packet;
+            visit([&](const std::shared_ptr<Context>& conn) {
+                if (!conn->isConnected())
+                {
+                    return true;
+                }
+                if (conn->isQueued())
+                {
+                    conn->invoke(packet, arg_traits_t<A>(args)...);
+                    return true;
+                }
+                return combiner(conn->call(arg_traits_t<A>(args)...));
+            });
+            return combiner.result();
         }
 
         void operator()(A ...args)
         {
             return (*this).emit(std::forward<A>(args)...);
         }
+
+    private:
+        //calls visitor on every connection of a snapshot until it returns false
+        template<class Visitor>
+        void visit(Visitor&& visitor)
+        {
+            if constexpr (is_rcu)
+            {
+                Rcu::ReadGuard guard;
+                const Connections* connections = published_.load(std::memory_order_acquire);
+                for (const auto& conn : *connections)
+                {
+                    if (!visitor(conn))
+                    {
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                std::shared_ptr<Connections> connections;
+                Released released;
+                {
+                    std::lock_guard<ThreadPolicy> lock(lock_);
+                    releaseUnreleased(released);
+                    connections = connections_;
+                }
+                released.clear();
+                //the snapshot keeps every context alive, no need to copy them
+                for (const auto& conn : *connections)
+                {
+                    if (conn && !visitor(conn))
+                    {
+                        break;
+                    }
+                }
+            }
+        }
     };
 
-    template<class S, class ThreadPolicy = def_thread_policy>
-    class Event : public Event<S, ThreadPolicy>
+    //combiners for Event::emitWith: operator() takes one slot's result and returns false
+    //once the answer is known, result() is what emitWith returns
+    namespace combiner
     {
-    };
+        //first result that tests true, e.g. a non-null pointer, or R() if none does
+        template<class R>
+        class FirstNonNull
+        {
+            R value_{};
+        public:
+            bool operator()(R value)
+            {
+                if (value)
+                {
+                    value_ = std::move(value);
+                    return false;
+                }
+                return true;
+            }
+
+            R result()
+            {
+                return std::move(value_);
+            }
+        };
+
+        //veto chain: false from the first slot that says no, true if none does
+        class AllOf
+        {
+            bool value_ = true;
+        public:
+            bool operator()(bool value)
+            {
+                value_ = value;
+                return value;
+            }
+
+            bool result() const
+            {
+                return value_;
+            }
+        };
+
+        template<class R>
+        class Sum
+        {
+            R value_{};
+        public:
+            bool operator()(const R& value)
+            {
+                value_ += value;
+                return true;
+            }
+
+            R result() const
+            {
+                return value_;
+            }
+        };
+
+        //appends results to buffer, stops after limit of them
+        template<class R>
+        class Collect
+        {
+            std::vector<R>& buffer_;
+            size_t limit_;
+        public:
+            explicit Collect(std::vector<R>& buffer, size_t limit = SIZE_MAX)
+                : buffer_(buffer), limit_(limit)
+            {
+                assert(limit != 0);
+            }
+
+            bool operator()(R value)
+            {
+                buffer_.push_back(std::move(value));
+                return --limit_ != 0;
+            }
+
+            std::vector<R>& result()
+            {
+                return buffer_;
+            }
+        };
+    }
 
 }
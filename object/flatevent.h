@@ -0,0 +1,252 @@
+#pragma once
+#include "event.h"
+
+namespace Storm
+{
+    template <class>
+    class FlatEvent;
+
+    //single threaded event that keeps its slots inline in one contiguous array:
+    //emit is a linear scan with one indirect call per slot, no shared_ptr, no atomics.
+    //connections are generation tagged handles into a slot table, so a handle whose slot
+    //is gone is harmless. slots run in connection order, a slot added during emit runs
+    //from the next emit on, a slot removed during emit does not run any more.
+    template <class R, class ...A>
+    class FlatEvent<R(A ...)>
+    {
+        FlatEvent(const FlatEvent&) = delete;
+        FlatEvent& operator=(const FlatEvent&) = delete;
+
+    public:
+        using Slot = InlineCallback<R(A ...)>;
+
+        //must not outlive its event
+        class Connection
+        {
+            friend class FlatEvent;
+            FlatEvent* event_ = nullptr;
+            uint32_t index_ = 0;
+            uint32_t generation_ = 0;
+
+            Connection(FlatEvent* event, uint32_t index, uint32_t generation)
+                : event_(event), index_(index), generation_(generation)
+            {
+            }
+
+        public:
+            Connection() = default;
+
+            void disconnect() const
+            {
+                if (event_)
+                {
+                    event_->remove(*this);
+                }
+            }
+
+            bool isConnected() const
+            {
+                return event_ && event_->isConnected(*this);
+            }
+        };
+
+    private:
+        struct Entry
+        {
+            Slot slot;
+            uint32_t handle;
+            bool live;
+        };
+
+        //slot table entry, position is the slot's index in slots_ while it is connected
+        struct Handle
+        {
+            uint32_t position;
+            uint32_t generation;
+        };
+
+        static constexpr uint32_t kFree = UINT32_MAX;
+
+        std::vector<Entry> slots_;
+        //added during emit, appended once the outermost emit is done
+        std::vector<Entry> pending_;
+        std::vector<Handle> handles_;
+        std::vector<uint32_t> freeHandles_;
+        size_t dead_ = 0;
+        int emitting_ = 0;
+
+        struct EmitScope
+        {
+            FlatEvent* event;
+
+            ~EmitScope()
+            {
+                if (--event->emitting_ == 0)
+                {
+                    event->settle();
+                }
+            }
+        };
+
+        Entry* entry(uint32_t position)
+        {
+            return position < slots_.size() ? &slots_[position] : &pending_[position - slots_.size()];
+        }
+
+        Connection connect(Slot&& slot)
+        {
+            assert(!slot.isEmpty());
+            uint32_t index;
+            if (freeHandles_.empty())
+            {
+                index = (uint32_t)handles_.size();
+                handles_.push_back(Handle{ kFree, 0 });
+            }
+            else
+            {
+                index = freeHandles_.back();
+                freeHandles_.pop_back();
+            }
+
+            //slots_ must not grow under a running slot
+            std::vector<Entry>& target = emitting_ ? pending_ : slots_;
+            handles_[index].position = (uint32_t)(slots_.size() + (emitting_ ? pending_.size() : 0));
+            target.push_back(Entry{ std::move(slot), index, true });
+            return Connection(this, index, handles_[index].generation);
+        }
+
+        //drops dead slots and moves pending ones in, keeps the order
+        void compact()
+        {
+            auto it = std::remove_if(slots_.begin(), slots_.end(), [](const Entry& e) {
+                return !e.live;
+            });
+            slots_.erase(it, slots_.end());
+            dead_ = 0;
+            for (auto& e : pending_)
+            {
+                if (e.live)
+                {
+                    slots_.push_back(std::move(e));
+                }
+            }
+            pending_.clear();
+            for (uint32_t position = 0; position != slots_.size(); ++position)
+            {
+                handles_[slots_[position].handle].position = position;
+            }
+        }
+
+        void settle()
+        {
+            if (!pending_.empty() || dead_ > slots_.size() / 2)
+            {
+                compact();
+            }
+        }
+
+    public:
+        FlatEvent() = default;
+
+        Connection add(Slot&& slot)
+        {
+            return connect(std::move(slot));
+        }
+
+        Connection add(const Slot& slot)
+        {
+            return connect(Slot(slot));
+        }
+
+        template <class F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Slot>::value, bool>>
+        Connection add(F&& function)
+        {
+            return connect(Slot(std::forward<F>(function)));
+        }
+
+        template <class C, class O>
+        Connection add(R(C::*function)(A ...), O* object)
+        {
+            return connect(Storm::delegateInline(function, object));
+        }
+
+        //true if the connection was live
+        bool remove(const Connection& connection)
+        {
+            if (connection.event_ != this || !isConnected(connection))
+            {
+                return false;
+            }
+            Handle& handle = handles_[connection.index_];
+            //the slot may be running right now, it is destroyed by the next compaction
+            entry(handle.position)->live = false;
+            handle.position = kFree;
+            handle.generation += 1;
+            freeHandles_.push_back(connection.index_);
+            dead_ += 1;
+            if (!emitting_)
+            {
+                settle();
+            }
+            return true;
+        }
+
+        bool isConnected(const Connection& connection) const
+        {
+            return connection.event_ == this && connection.index_ < handles_.size()
+                && handles_[connection.index_].generation == connection.generation_
+                && handles_[connection.index_].position != kFree;
+        }
+
+        void removeAll()
+        {
+            for (uint32_t index = 0; index != handles_.size(); ++index)
+            {
+                Handle& handle = handles_[index];
+                if (handle.position != kFree)
+                {
+                    entry(handle.position)->live = false;
+                    handle.position = kFree;
+                    handle.generation += 1;
+                    freeHandles_.push_back(index);
+                    dead_ += 1;
+                }
+            }
+            if (!emitting_)
+            {
+                settle();
+            }
+        }
+
+        size_t size() const
+        {
+            return slots_.size() + pending_.size() - dead_;
+        }
+
+        void operator +=(Slot&& slot)
+        {
+            add(std::move(slot));
+        }
+
+        void emit(arg_traits_t<A>...args)
+        {
+            emitting_ += 1;
+            EmitScope scope{ this };
+            //slots_ neither grows nor shrinks until the outermost emit is done
+            const size_t count = slots_.size();
+            for (size_t i = 0; i != count; ++i)
+            {
+                const Entry& e = slots_[i];
+                if (e.live)
+                {
+                    e.slot(arg_traits_t<A>(args)...);
+                }
+            }
+        }
+
+        void operator()(A ...args)
+        {
+            return (*this).emit(std::forward<A>(args)...);
+        }
+    };
+}
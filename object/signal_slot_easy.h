@@ -169,5 +169,177 @@ namespace signal_slot_esay
             }
         }
     };
+
+    template<class>
+    class concurrent_signal;
+
+    template<class>
+    class concurrent_connection_context;
+
+    template<class ...A>
+    class concurrent_connection_context<void(A...)> : public connection_context_base
+    {
+        std::function<void(A...)> slot_fun_;
+        std::mutex lock_;
+        signal_base* signal_;
+    public:
+        concurrent_connection_context(signal_base* signal, std::function<void(A...)>&& slot_fun)
+            : slot_fun_(std::move(slot_fun)), signal_(signal)
+        {
+
+        }
+
+        //lock order: context, then signal
+        virtual void disconnectSelf()
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (signal_)
+            {
+                signal_->removeConnection(this);
+                signal_ = nullptr;
+            }
+        }
+
+        //the signal is going away
+        void detach()
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            signal_ = nullptr;
+            disconnected();
+        }
+
+        void invoke(arg_traits_t<A>... args)
+        {
+            if (isConnected())
+            {
+                slot_fun_(std::forward<arg_traits_t<A>>(args)...);
+            }
+        }
+    };
+
+    //signal that can be connected, disconnected and emitted from any thread.
+    //slots sit in a contiguous array, a version of it is never changed below its size once
+    //published: connect appends in place, emit walks the size it saw without holding the lock.
+    //disconnect only marks the slot dead, a new version without the dead ones is made when
+    //the array is full or half dead. a slot may still be running when disconnect returns.
+    template<class ...A>
+    class concurrent_signal<void(A...)> : public signal_base
+    {
+        using context = concurrent_connection_context<void(A...)>;
+
+        struct slot_array
+        {
+            std::unique_ptr<std::shared_ptr<context>[]> slots;
+            size_t capacity;
+            //written under the signal's lock, read by emit under it
+            size_t size = 0;
+
+            explicit slot_array(size_t capacity)
+                : slots(new std::shared_ptr<context>[capacity]), capacity(capacity)
+            {
+            }
+        };
+
+        std::mutex lock_;
+        std::shared_ptr<slot_array> slots_;
+        size_t dead_ = 0;
+
+        //copies the live slots into a new version with room to grow, returns the old one
+        //for the caller to drop unlocked, it may hold the last reference to dead slots
+        std::shared_ptr<slot_array> rebuild(size_t live)
+        {
+            auto fresh = std::make_shared<slot_array>(std::max<size_t>(8, live * 2));
+            if (slots_)
+            {
+                for (size_t i = 0; i != slots_->size; ++i)
+                {
+                    if (slots_->slots[i]->isConnected())
+                    {
+                        fresh->slots[fresh->size++] = slots_->slots[i];
+                    }
+                }
+            }
+            std::swap(slots_, fresh);
+            dead_ = 0;
+            return fresh;
+        }
+
+        void removeConnection(connection_context_base* conn) override
+        {
+            std::shared_ptr<slot_array> old;
+            std::lock_guard<std::mutex> lock(lock_);
+            //no slots_ once the destructor took them, it detaches this connection next
+            if (!slots_ || !conn->isConnected())
+            {
+                return;
+            }
+            conn->disconnected();
+            dead_ += 1;
+            if (dead_ > slots_->size / 2)
+            {
+                old = rebuild(slots_->size - dead_);
+            }
+        }
+
+    public:
+        concurrent_signal()
+        {
+            rebuild(0);
+        }
+
+        ~concurrent_signal()
+        {
+            std::shared_ptr<slot_array> slots;
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                slots = std::move(slots_);
+            }
+            for (size_t i = 0; i != slots->size; ++i)
+            {
+                slots->slots[i]->detach();
+            }
+        }
+
+        connection connect(std::function<void(A...)>&& slot_func)
+        {
+            auto conn = std::make_shared<context>(this, std::move(slot_func));
+            std::shared_ptr<slot_array> old;
+            std::lock_guard<std::mutex> lock(lock_);
+            if (slots_->size == slots_->capacity)
+            {
+                old = rebuild(slots_->size - dead_ + 1);
+            }
+            //beyond the size any emit has seen, so no reader touches it
+            slots_->slots[slots_->size] = conn;
+            slots_->size += 1;
+            return connection(conn);
+        }
+
+        size_t size()
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            return slots_->size - dead_;
+        }
+
+        void operator()(A... args)
+        {
+            (*this).emit(std::forward<A>(args)...);
+        }
+
+        void emit(arg_traits_t<A>... args)
+        {
+            std::shared_ptr<slot_array> slots;
+            size_t size = 0;
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                slots = slots_;
+                size = slots->size;
+            }
+            for (size_t i = 0; i != size; ++i)
+            {
+                slots->slots[i]->invoke(arg_traits_t<A>(args)...);
+            }
+        }
+    };
 }
 
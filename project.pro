@@ -7,6 +7,9 @@ QMAKE_CXXFLAGS += /await
 QMAKE_CXXFLAGS += /std:c++latest
 
 PRECOMPILED_HEADER = stable.h
+
+#example_workerpool_stats checks the per worker counters, the whole target must agree on it
+DEFINES += WORKERPOOL_ENABLE_STATS
 SOURCES += $$files(main.cpp)
 
 INCLUDEPATH += ./
@@ -59,5 +62,7 @@ equals(QT_MAJOR_VERSION, 5) {
 HEADERS += adapter/ppl/appasync.h
 SOURCES += adapter/ppl/appasync.cpp
 
+HEADERS += adapter/std/appasync.h
+
 HEADERS += json/nlohmann/json.hpp
 HEADERS += json/json_auto.h
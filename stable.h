@@ -10,6 +10,8 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <cstddef>
+#include <cstring>
 #include <stdio.h>
 #include <limits.h>
 #include <math.h>
@@ -25,17 +27,24 @@
 #include <queue>
 #include <list>
 #include <array>
+#include <optional>
 #include <memory>
 #include <numeric>
+#include <random>
 #include <algorithm>
 #include <functional>
+#include <stdexcept>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <atomic>
+#include <bit>
 #include <chrono>
 #include <tuple>
+#include <utility>
 #include <future>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
\ No newline at end of file
+#include <shared_mutex>
+#include <condition_variable>
+#include <coroutine>
\ No newline at end of file
@@ -0,0 +1,277 @@
+#pragma once
+
+//lock free bounded multi producer multi consumer queue, same usage as SyncQueue.
+//slots are preallocated and tagged with a sequence number, consumers only park
+//(std::atomic wait, a futex on linux) when the queue is empty.
+template<class T>
+class BoundedSyncQueue
+{
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* item() { return reinterpret_cast<T*>(storage); }
+    };
+
+    static constexpr size_t kCacheLine = 64;
+
+    std::unique_ptr<Cell[]> buffer_;
+    size_t mask_ = 0;
+
+    alignas(kCacheLine) std::atomic<size_t> enqueuePos_ = 0;
+    alignas(kCacheLine) std::atomic<size_t> dequeuePos_ = 0;
+
+    alignas(kCacheLine) std::atomic<bool> stop_ = false;
+    std::atomic<uint32_t> waiters_ = 0;
+    std::atomic<uint32_t> wakeEpoch_ = 0;
+
+    BoundedSyncQueue(const BoundedSyncQueue&) = delete;
+    BoundedSyncQueue &operator=(const BoundedSyncQueue &) = delete;
+
+public:
+    explicit BoundedSyncQueue(size_t capacity = 1024);
+    ~BoundedSyncQueue();
+
+    void start();
+    void stop();
+
+    size_t capacity() const;
+    bool isEmpty();
+
+    //enqueue spins when the queue is full, use try_enqueue to fail fast
+    void enqueue(const T& item);
+    void enqueue(T&& item);
+    bool try_enqueue(const T& item);
+    bool try_enqueue(T&& item);
+
+    bool try_dequeue(T& item);
+    bool try_dequeueAll(std::deque<T>& items);
+
+    bool dequeue(T& item);
+    bool dequeueAll(std::deque<T>& items);
+
+private:
+    template<class U> bool push(U&& item);
+    void wakeWaiters();
+    bool waitNotEmpty();
+};
+
+template<class T> BoundedSyncQueue<T>::BoundedSyncQueue(size_t capacity /*= 1024*/)
+{
+    size_t size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+
+    buffer_.reset(new Cell[size]);
+    mask_ = size - 1;
+    for (size_t i = 0; i != size; ++i)
+    {
+        buffer_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template<class T> BoundedSyncQueue<T>::~BoundedSyncQueue()
+{
+    stop();
+
+    T item;
+    while (try_dequeue(item))
+    {
+    }
+}
+
+template<class T> void BoundedSyncQueue<T>::start()
+{
+    stop_ = false;
+}
+
+template<class T> void BoundedSyncQueue<T>::stop()
+{
+    stop_ = true;
+    wakeEpoch_.fetch_add(1);
+    wakeEpoch_.notify_all();
+}
+
+template<class T> size_t BoundedSyncQueue<T>::capacity() const
+{
+    return mask_ + 1;
+}
+
+template<class T> bool BoundedSyncQueue<T>::isEmpty()
+{
+    size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    size_t seq = buffer_[pos & mask_].sequence.load(std::memory_order_acquire);
+    return (intptr_t)seq - (intptr_t)(pos + 1) < 0;
+}
+
+template<class T> void BoundedSyncQueue<T>::enqueue(const T& item)
+{
+    while (!push(item))
+    {
+        std::this_thread::yield();
+    }
+}
+
+template<class T> void BoundedSyncQueue<T>::enqueue(T&& item)
+{
+    while (!push(std::move(item)))
+    {
+        std::this_thread::yield();
+    }
+}
+
+template<class T> bool BoundedSyncQueue<T>::try_enqueue(const T& item)
+{
+    return push(item);
+}
+
+template<class T> bool BoundedSyncQueue<T>::try_enqueue(T&& item)
+{
+    return push(std::move(item));
+}
+
+template<class T> bool BoundedSyncQueue<T>::try_dequeue(T& item)
+{
+    Cell* cell = nullptr;
+    size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        cell = &buffer_[pos & mask_];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0)
+        {
+            if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = dequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    item = std::move(*cell->item());
+    cell->item()->~T();
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+}
+
+template<class T> bool BoundedSyncQueue<T>::try_dequeueAll(std::deque<T>& items)
+{
+    T item;
+    if (!try_dequeue(item))
+    {
+        return false;
+    }
+
+    items.clear();
+    do
+    {
+        items.push_back(std::move(item));
+    } while (try_dequeue(item));
+    return true;
+}
+
+template<class T> bool BoundedSyncQueue<T>::dequeue(T& item)
+{
+    while (true)
+    {
+        if (stop_)
+        {
+            return false;
+        }
+        if (try_dequeue(item))
+        {
+            return true;
+        }
+        if (!waitNotEmpty())
+        {
+            return false;
+        }
+    }
+}
+
+template<class T> bool BoundedSyncQueue<T>::dequeueAll(std::deque<T>& items)
+{
+    while (true)
+    {
+        if (stop_)
+        {
+            return false;
+        }
+        if (try_dequeueAll(items))
+        {
+            return true;
+        }
+        if (!waitNotEmpty())
+        {
+            return false;
+        }
+    }
+}
+
+template<class T> template<class U> bool BoundedSyncQueue<T>::push(U&& item)
+{
+    Cell* cell = nullptr;
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        cell = &buffer_[pos & mask_];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0)
+        {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    new (cell->storage) T(std::forward<U>(item));
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    wakeWaiters();
+    return true;
+}
+
+template<class T> void BoundedSyncQueue<T>::wakeWaiters()
+{
+    //pairs with the fetch_add in waitNotEmpty, either we see the waiter or it sees our item
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) != 0)
+    {
+        wakeEpoch_.fetch_add(1);
+        wakeEpoch_.notify_one();
+    }
+}
+
+template<class T> bool BoundedSyncQueue<T>::waitNotEmpty()
+{
+    waiters_.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint32_t epoch = wakeEpoch_.load();
+    if (isEmpty() && !stop_)
+    {
+        wakeEpoch_.wait(epoch);
+    }
+    waiters_.fetch_sub(1);
+    return !stop_;
+}
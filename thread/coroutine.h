@@ -0,0 +1,498 @@
+#pragma once
+
+#include "workerpool.h"
+
+//portable C++20 coroutines: a lazy task<T>, when_all and sync_wait.
+//a task starts when awaited and resumes its awaiter by symmetric transfer when done,
+//so long await chains neither grow the stack nor allocate anything besides the frames.
+//
+//  coro::task<int> work(WorkerPool& pool)
+//  {
+//      co_await pool.schedule();
+//      auto [a, b] = co_await coro::when_all(compute(1), compute(2));
+//      co_return a + b;
+//  }
+//  int result = coro::sync_wait(work(pool));
+namespace coro
+{
+    template<class T = void> class task;
+
+    namespace priv
+    {
+        template<class T>
+        using Result = std::conditional_t<std::is_void<T>::value, ::priv::Unit, T>;
+
+        struct PromiseBase
+        {
+            std::coroutine_handle<> continuation = std::noop_coroutine();
+            std::exception_ptr error;
+
+            struct FinalAwaiter
+            {
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                template<class Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+                {
+                    return handle.promise().continuation;
+                }
+
+                void await_resume() const noexcept
+                {
+                }
+            };
+
+            std::suspend_always initial_suspend() const noexcept
+            {
+                return {};
+            }
+
+            FinalAwaiter final_suspend() const noexcept
+            {
+                return {};
+            }
+
+            void unhandled_exception()
+            {
+                error = std::current_exception();
+            }
+
+            void rethrow()
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+
+        template<class T>
+        struct Promise : PromiseBase
+        {
+            std::optional<T> value;
+
+            task<T> get_return_object();
+
+            template<class U>
+            void return_value(U&& result)
+            {
+                value.emplace(std::forward<U>(result));
+            }
+
+            T result()
+            {
+                rethrow();
+                return std::move(*value);
+            }
+        };
+
+        template<>
+        struct Promise<void> : PromiseBase
+        {
+            task<void> get_return_object();
+
+            void return_void()
+            {
+            }
+
+            void result()
+            {
+                rethrow();
+            }
+        };
+    }
+
+    template<class T>
+    class task
+    {
+    public:
+        using promise_type = priv::Promise<T>;
+        using handle_type = std::coroutine_handle<promise_type>;
+
+    private:
+        handle_type handle_;
+
+        task(const task&) = delete;
+        task& operator=(const task&) = delete;
+
+        struct Awaiter
+        {
+            handle_type handle;
+
+            bool await_ready() const noexcept
+            {
+                return !handle || handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume()
+            {
+                return handle.promise().result();
+            }
+        };
+
+        //like Awaiter but leaves the result or exception in place
+        struct ReadyAwaiter : Awaiter
+        {
+            void await_resume() const noexcept
+            {
+            }
+        };
+
+    public:
+        task() = default;
+        explicit task(handle_type handle) : handle_(handle) {}
+
+        task(task&& other) noexcept
+            : handle_(std::exchange(other.handle_, nullptr))
+        {
+        }
+
+        task& operator=(task&& other) noexcept
+        {
+            std::swap(handle_, other.handle_);
+            return *this;
+        }
+
+        ~task()
+        {
+            if (handle_)
+            {
+                handle_.destroy();
+            }
+        }
+
+        bool valid() const
+        {
+            return (bool)handle_;
+        }
+
+        bool isReady() const
+        {
+            return !handle_ || handle_.done();
+        }
+
+        Awaiter operator co_await() const noexcept
+        {
+            return Awaiter{ handle_ };
+        }
+
+        //runs the task without taking its result
+        ReadyAwaiter whenReady() const noexcept
+        {
+            return ReadyAwaiter{ { handle_ } };
+        }
+
+        //result of a finished task, void results become ::priv::Unit
+        priv::Result<T> result()
+        {
+            assert(isReady());
+            if constexpr (std::is_void<T>::value)
+            {
+                handle_.promise().result();
+                return {};
+            }
+            else
+            {
+                return handle_.promise().result();
+            }
+        }
+    };
+
+    namespace priv
+    {
+        template<class T>
+        task<T> Promise<T>::get_return_object()
+        {
+            return task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+        }
+
+        inline task<void> Promise<void>::get_return_object()
+        {
+            return task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+        }
+
+        //runs one child of when_all, the last finished child resumes the awaiting coroutine
+        struct WhenAllCounter
+        {
+            std::atomic<size_t> count;
+            std::coroutine_handle<> awaiting;
+        };
+
+        class WhenAllDriver
+        {
+        public:
+            struct promise_type
+            {
+                WhenAllCounter* counter = nullptr;
+
+                struct FinalAwaiter
+                {
+                    bool await_ready() const noexcept
+                    {
+                        return false;
+                    }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                    {
+                        WhenAllCounter* counter = handle.promise().counter;
+                        if (counter->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        {
+                            return counter->awaiting;
+                        }
+                        return std::noop_coroutine();
+                    }
+
+                    void await_resume() const noexcept
+                    {
+                    }
+                };
+
+                WhenAllDriver get_return_object()
+                {
+                    return WhenAllDriver(std::coroutine_handle<promise_type>::from_promise(*this));
+                }
+
+                std::suspend_always initial_suspend() const noexcept
+                {
+                    return {};
+                }
+
+                FinalAwaiter final_suspend() const noexcept
+                {
+                    return {};
+                }
+
+                void return_void()
+                {
+                }
+
+                void unhandled_exception()
+                {
+                    std::terminate();
+                }
+            };
+
+            explicit WhenAllDriver(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+            WhenAllDriver(WhenAllDriver&& other) noexcept
+                : handle_(std::exchange(other.handle_, nullptr))
+            {
+            }
+
+            ~WhenAllDriver()
+            {
+                if (handle_)
+                {
+                    handle_.destroy();
+                }
+            }
+
+            void start(WhenAllCounter* counter)
+            {
+                handle_.promise().counter = counter;
+                handle_.resume();
+            }
+
+        private:
+            std::coroutine_handle<promise_type> handle_;
+        };
+
+        template<class T>
+        WhenAllDriver drive(task<T>& child)
+        {
+            co_await child.whenReady();
+        }
+
+        //starts every driver, resumes the awaiting coroutine once all of them finished
+        class WhenAllAwaiter
+        {
+            std::vector<WhenAllDriver>& drivers_;
+            WhenAllCounter counter_;
+
+        public:
+            explicit WhenAllAwaiter(std::vector<WhenAllDriver>& drivers)
+                : drivers_(drivers)
+            {
+                counter_.count = drivers.size() + 1;
+            }
+
+            bool await_ready() const noexcept
+            {
+                return drivers_.empty();
+            }
+
+            bool await_suspend(std::coroutine_handle<> awaiting)
+            {
+                counter_.awaiting = awaiting;
+                for (auto& driver : drivers_)
+                {
+                    driver.start(&counter_);
+                }
+                //everyone finished inline, carry on without suspending
+                return counter_.count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+        };
+
+        //sync_wait's driver, signals a waiting thread when the task is done
+        struct SyncWaitState
+        {
+            std::mutex lock;
+            std::condition_variable cv;
+            bool done = false;
+        };
+
+        class SyncWaitDriver
+        {
+        public:
+            struct promise_type
+            {
+                SyncWaitState* state = nullptr;
+
+                struct FinalAwaiter
+                {
+                    bool await_ready() const noexcept
+                    {
+                        return false;
+                    }
+
+                    void await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                    {
+                        //notified under the lock, the waiter may destroy state right after
+                        SyncWaitState* state = handle.promise().state;
+                        std::lock_guard<std::mutex> guard(state->lock);
+                        state->done = true;
+                        state->cv.notify_all();
+                    }
+
+                    void await_resume() const noexcept
+                    {
+                    }
+                };
+
+                SyncWaitDriver get_return_object()
+                {
+                    return SyncWaitDriver(std::coroutine_handle<promise_type>::from_promise(*this));
+                }
+
+                std::suspend_always initial_suspend() const noexcept
+                {
+                    return {};
+                }
+
+                FinalAwaiter final_suspend() const noexcept
+                {
+                    return {};
+                }
+
+                void return_void()
+                {
+                }
+
+                void unhandled_exception()
+                {
+                    std::terminate();
+                }
+            };
+
+            explicit SyncWaitDriver(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+            ~SyncWaitDriver()
+            {
+                handle_.destroy();
+            }
+
+            void run()
+            {
+                SyncWaitState state;
+                handle_.promise().state = &state;
+                handle_.resume();
+
+                std::unique_lock<std::mutex> lock(state.lock);
+                state.cv.wait(lock, [&state]() {
+                    return state.done;
+                });
+            }
+
+        private:
+            std::coroutine_handle<promise_type> handle_;
+        };
+
+        template<class T>
+        SyncWaitDriver driveSync(task<T>& child)
+        {
+            co_await child.whenReady();
+        }
+    }
+
+    //blocks the calling thread until the task finished, returns its result or rethrows
+    template<class T>
+    T sync_wait(task<T>&& work)
+    {
+        priv::driveSync(work).run();
+        if constexpr (std::is_void<T>::value)
+        {
+            work.result();
+        }
+        else
+        {
+            return work.result();
+        }
+    }
+
+    //runs all tasks concurrently (as far as they suspend, e.g. on pool.schedule()),
+    //the result tuple maps void tasks to ::priv::Unit. of the failed tasks, the exception of the one
+    //passed first is rethrown.
+    template<class... T>
+    task<std::tuple<priv::Result<T>...>> when_all(task<T>... tasks)
+    {
+        std::vector<priv::WhenAllDriver> drivers;
+        drivers.reserve(sizeof...(T));
+        (drivers.push_back(priv::drive(tasks)), ...);
+        co_await priv::WhenAllAwaiter(drivers);
+        //a braced list is evaluated left to right, so results are taken in argument order
+        co_return std::tuple<priv::Result<T>...>{ tasks.result()... };
+    }
+
+    template<class T>
+    task<std::conditional_t<std::is_void<T>::value, void, std::vector<T>>> when_all(std::vector<task<T>> tasks)
+    {
+        std::vector<priv::WhenAllDriver> drivers;
+        drivers.reserve(tasks.size());
+        for (auto& child : tasks)
+        {
+            drivers.push_back(priv::drive(child));
+        }
+        co_await priv::WhenAllAwaiter(drivers);
+
+        if constexpr (std::is_void<T>::value)
+        {
+            for (auto& child : tasks)
+            {
+                child.result();
+            }
+        }
+        else
+        {
+            std::vector<T> results;
+            results.reserve(tasks.size());
+            for (auto& child : tasks)
+            {
+                results.push_back(child.result());
+            }
+            co_return results;
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "task.h"
+
+//anything that runs tasks somewhere: WorkerPool, Strand, the Qt ui thread (Qx::executor())...
+class Executor
+{
+public:
+    virtual ~Executor() = default;
+
+    virtual void post(Task&& task) = 0;
+
+    //false when the executor refused the task (e.g. a stopped pool), task is then left as it was
+    //and the caller runs or drops it. executors that never refuse just post
+    virtual bool tryPost(Task&& task)
+    {
+        post(std::move(task));
+        return true;
+    }
+};
+
+//callable view of an Executor, what Future::then expects
+struct ExecutorRef
+{
+    Executor* executor;
+
+    void operator()(Task&& task) const
+    {
+        executor->post(std::move(task));
+    }
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "workerpool.h"
+#include "rwlock.h"
+
+//executors by name, so code can hop between them without knowing what runs behind a name.
+//"pool" and "io" always exist, "ui" once a ui framework registered one (QxApplication does).
+class Executors
+{
+    RWSpinLock lock_;
+    std::map<std::string, Executor*> executors_;
+
+    Executors();
+
+    static Executors& instance();
+
+public:
+    //the executor must outlive its registration, nullptr removes the name
+    static void set(const std::string& name, Executor* executor);
+    //nullptr for an unknown name
+    static Executor* get(const std::string& name);
+
+    static Executor* pool();
+    static Executor* io();
+    //falls back to pool() while no ui is registered
+    static Executor* ui();
+};
+
+inline Executors::Executors()
+{
+    executors_["pool"] = WorkerPool::pool();
+    executors_["io"] = WorkerPool::ioPool();
+}
+
+//if build this as a dynamic library make sure put this function into cpp source file
+inline Executors& Executors::instance()
+{
+    static Executors executors;
+    return executors;
+}
+
+inline void Executors::set(const std::string& name, Executor* executor)
+{
+    Executors& self = instance();
+    std::unique_lock<RWSpinLock> lock(self.lock_);
+    if (executor)
+    {
+        self.executors_[name] = executor;
+    }
+    else
+    {
+        self.executors_.erase(name);
+    }
+}
+
+inline Executor* Executors::get(const std::string& name)
+{
+    Executors& self = instance();
+    std::shared_lock<RWSpinLock> lock(self.lock_);
+    auto it = self.executors_.find(name);
+    return it == self.executors_.end() ? nullptr : it->second;
+}
+
+inline Executor* Executors::pool()
+{
+    return get("pool");
+}
+
+inline Executor* Executors::io()
+{
+    return get("io");
+}
+
+inline Executor* Executors::ui()
+{
+    Executor* executor = get("ui");
+    return executor ? executor : pool();
+}
@@ -0,0 +1,369 @@
+#pragma once
+
+#include "task.h"
+
+//lightweight one shot future / promise pair.
+//one intrusive ref counted allocation per pair, no mutex, waiting uses std::atomic wait.
+//a continuation attached with then() is stored inline in the shared state.
+template<class R> class Future;
+template<class R> class Promise;
+
+namespace priv
+{
+    struct Unit
+    {
+    };
+
+    template<class T> struct IsFuture : std::false_type {};
+    template<class T> struct IsFuture<Future<T>> : std::true_type {};
+
+    template<class T> struct Unwrapped { using type = T; };
+    template<class T> struct Unwrapped<Future<T>> { using type = T; };
+
+    //what func returns when handed the value of a Future<R>
+    template<class R, class F>
+    using ThenResult = typename std::conditional_t<std::is_void<R>::value, std::invoke_result<F>, std::invoke_result<F, R>>::type;
+
+    //runs a task right on the thread that completed the future
+    struct InlineExecutor
+    {
+        void operator()(Task&& task) const
+        {
+            task();
+        }
+    };
+
+    template<class R>
+    class FutureState
+    {
+        static_assert(!std::is_reference<R>::value, "Future does not hold references");
+        using value_type = std::conditional_t<std::is_void<R>::value, Unit, R>;
+
+        enum : uint32_t
+        {
+            kReady = 1,
+            kContinuation = 2,
+        };
+
+        std::atomic<int> refs_ = 1;
+        std::atomic<uint32_t> ready_ = 0;
+        std::optional<value_type> value_;
+        std::exception_ptr error_;
+        Task continuation_;
+
+        FutureState(const FutureState&) = delete;
+        FutureState& operator=(const FutureState&) = delete;
+
+    public:
+        FutureState() = default;
+
+        void addRef()
+        {
+            refs_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release()
+        {
+            if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                delete this;
+            }
+        }
+
+        bool isReady() const
+        {
+            return (ready_.load(std::memory_order_acquire) & kReady) != 0;
+        }
+
+        void wait() const
+        {
+            uint32_t state = ready_.load(std::memory_order_acquire);
+            while (!(state & kReady))
+            {
+                ready_.wait(state, std::memory_order_acquire);
+                state = ready_.load(std::memory_order_acquire);
+            }
+        }
+
+        //whichever of setReady and setContinuation comes second runs the continuation
+        void setContinuation(Task&& continuation)
+        {
+            continuation_ = std::move(continuation);
+            if (ready_.fetch_or(kContinuation, std::memory_order_acq_rel) & kReady)
+            {
+                runContinuation();
+            }
+        }
+
+        template<class... A>
+        void setValue(A&&... args)
+        {
+            value_.emplace(std::forward<A>(args)...);
+            setReady();
+        }
+
+        void setError(std::exception_ptr error)
+        {
+            error_ = std::move(error);
+            setReady();
+        }
+
+        template<class F>
+        void run(F& func)
+        {
+            try
+            {
+                if constexpr (std::is_void<R>::value)
+                {
+                    func();
+                    setValue();
+                }
+                else
+                {
+                    setValue(func());
+                }
+            }
+            catch (...)
+            {
+                setError(std::current_exception());
+            }
+        }
+
+        R get()
+        {
+            wait();
+            if (error_)
+            {
+                std::rethrow_exception(error_);
+            }
+            if constexpr (!std::is_void<R>::value)
+            {
+                return std::move(*value_);
+            }
+        }
+
+    private:
+        void setReady()
+        {
+            uint32_t state = ready_.fetch_or(kReady, std::memory_order_acq_rel);
+            ready_.notify_all();
+            if (state & kContinuation)
+            {
+                runContinuation();
+            }
+        }
+
+        void runContinuation()
+        {
+            Task continuation = std::move(continuation_);
+            continuation();
+        }
+    };
+}
+
+template<class R>
+class Future
+{
+    priv::FutureState<R>* state_ = nullptr;
+
+    template<class> friend class Future;
+    friend class Promise<R>;
+    explicit Future(priv::FutureState<R>* state) : state_(state) {}
+
+    Future(const Future&) = delete;
+    Future& operator=(const Future&) = delete;
+
+public:
+    Future() = default;
+
+    Future(Future&& other) noexcept
+        : state_(other.state_)
+    {
+        other.state_ = nullptr;
+    }
+
+    Future& operator=(Future&& other) noexcept
+    {
+        std::swap(state_, other.state_);
+        return *this;
+    }
+
+    ~Future()
+    {
+        if (state_)
+        {
+            state_->release();
+        }
+    }
+
+    bool valid() const
+    {
+        return state_ != nullptr;
+    }
+
+    bool isReady() const
+    {
+        assert(valid());
+        return state_->isReady();
+    }
+
+    void wait() const
+    {
+        assert(valid());
+        state_->wait();
+    }
+
+    //may only be called once, rethrows the exception thrown by the task
+    R get()
+    {
+        assert(valid());
+        return state_->get();
+    }
+
+    //consumes this future, once it is ready exec(Task) is asked to run func with its value.
+    //a failed future skips func and passes the exception on, a func returning a Future is unwrapped.
+    template<class Exec, class F>
+    auto then(Exec exec, F&& func) -> Future<typename priv::Unwrapped<priv::ThenResult<R, std::decay_t<F>>>::type>;
+
+private:
+    //completes target with the value or exception of this future
+    void pipe(Promise<R>&& target);
+};
+
+template<class R>
+class Promise
+{
+    priv::FutureState<R>* state_ = nullptr;
+    bool satisfied_ = false;
+
+    Promise(const Promise&) = delete;
+    Promise& operator=(const Promise&) = delete;
+
+public:
+    Promise()
+        : state_(new priv::FutureState<R>())
+    {
+    }
+
+    Promise(Promise&& other) noexcept
+        : state_(other.state_)
+        , satisfied_(other.satisfied_)
+    {
+        other.state_ = nullptr;
+    }
+
+    Promise& operator=(Promise&& other) noexcept
+    {
+        std::swap(state_, other.state_);
+        std::swap(satisfied_, other.satisfied_);
+        return *this;
+    }
+
+    ~Promise()
+    {
+        if (state_)
+        {
+            //dropped without a result, e.g. the pool was stopped before the task ran
+            if (!satisfied_)
+            {
+                state_->setError(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+            }
+            state_->release();
+        }
+    }
+
+    Future<R> future()
+    {
+        assert(state_);
+        state_->addRef();
+        return Future<R>(state_);
+    }
+
+    template<class... A>
+    void setValue(A&&... args)
+    {
+        assert(state_ && !satisfied_);
+        satisfied_ = true;
+        state_->setValue(std::forward<A>(args)...);
+    }
+
+    void setError(std::exception_ptr error)
+    {
+        assert(state_ && !satisfied_);
+        satisfied_ = true;
+        state_->setError(std::move(error));
+    }
+
+    //run func and store its result or exception
+    template<class F>
+    void run(F& func)
+    {
+        assert(state_ && !satisfied_);
+        satisfied_ = true;
+        state_->run(func);
+    }
+};
+
+template<class R>
+template<class Exec, class F>
+auto Future<R>::then(Exec exec, F&& func) -> Future<typename priv::Unwrapped<priv::ThenResult<R, std::decay_t<F>>>::type>
+{
+    using Result = priv::ThenResult<R, std::decay_t<F>>;
+    using Next = typename priv::Unwrapped<Result>::type;
+    assert(valid());
+
+    Promise<Next> promise;
+    Future<Next> next = promise.future();
+    priv::FutureState<R>* state = state_;
+
+    //the continuation takes over this future and only hops to exec, no allocation when captures are small.
+    //a task dropped by exec still releases everything and breaks the promise.
+    state->setContinuation([source = std::move(*this), exec = std::move(exec), promise = std::move(promise), func = std::forward<F>(func)]() mutable {
+        exec([source = std::move(source), promise = std::move(promise), func = std::move(func)]() mutable {
+            auto call = [&source, &func]() -> Result {
+                if constexpr (std::is_void<R>::value)
+                {
+                    source.get();
+                    return func();
+                }
+                else
+                {
+                    return func(source.get());
+                }
+            };
+
+            if constexpr (priv::IsFuture<Result>::value)
+            {
+                Result inner;
+                try
+                {
+                    inner = call();
+                }
+                catch (...)
+                {
+                    promise.setError(std::current_exception());
+                    return;
+                }
+                inner.pipe(std::move(promise));
+            }
+            else
+            {
+                promise.run(call);
+            }
+        });
+    });
+    return next;
+}
+
+template<class R>
+void Future<R>::pipe(Promise<R>&& target)
+{
+    assert(valid());
+    priv::FutureState<R>* state = state_;
+    state->setContinuation([source = std::move(*this), target = std::move(target)]() mutable {
+        auto forward = [&source]() -> R {
+            return source.get();
+        };
+        target.run(forward);
+    });
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "workerpool.h"
+
+//data parallel helpers on top of WorkerPool.
+//the calling thread always works on the range too, so they are safe to nest inside pool tasks.
+namespace parallel
+{
+    namespace priv
+    {
+        //guided self scheduling over [0, count): chunks shrink as the range drains, never below grain
+        class Range
+        {
+            std::atomic<size_t> next_ = 0;
+            std::atomic<size_t> done_ = 0;
+            const size_t count_;
+            const size_t grain_;
+            const size_t participants_;
+
+            std::atomic<bool> failed_ = false;
+            std::exception_ptr error_;
+
+        public:
+            Range(size_t count, size_t grain, size_t participants)
+                : count_(count), grain_(grain), participants_(participants)
+            {
+            }
+
+            bool next(size_t& begin, size_t& end)
+            {
+                size_t cur = next_.load(std::memory_order_relaxed);
+                while (cur < count_)
+                {
+                    size_t size = std::max(grain_, (count_ - cur) / (participants_ * 2));
+                    size_t to = std::min(count_, cur + size);
+                    if (next_.compare_exchange_weak(cur, to, std::memory_order_relaxed))
+                    {
+                        begin = cur;
+                        end = to;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void finished(size_t count)
+            {
+                if (done_.fetch_add(count) + count == count_)
+                {
+                    done_.notify_all();
+                }
+            }
+
+            void fail(std::exception_ptr error)
+            {
+                if (!failed_.exchange(true))
+                {
+                    error_ = error;
+                }
+            }
+
+            void wait()
+            {
+                size_t done = done_.load();
+                while (done != count_)
+                {
+                    done_.wait(done);
+                    done = done_.load();
+                }
+                if (error_)
+                {
+                    std::rethrow_exception(error_);
+                }
+            }
+        };
+
+        inline size_t autoGrain(size_t count, size_t participants)
+        {
+            return std::max<size_t>(1, count / (participants * 32));
+        }
+
+        //participant(range, begin, end) works on the first chunk and keeps pulling from range,
+        //it must call range.finished() for every element it took as its last access to itself.
+        template<class Participant>
+        void run(WorkerPool& pool, size_t count, size_t grain, Participant& participant)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+
+            size_t helpers = pool.size();
+            grain = grain ? grain : autoGrain(count, helpers + 1);
+            helpers = std::min(helpers, (count + grain - 1) / grain - 1);
+
+            auto range = std::make_shared<Range>(count, grain, helpers + 1);
+            for (size_t i = 0; i != helpers; ++i)
+            {
+                pool.add([range, &participant]() {
+                    //late helpers find the range drained and never touch participant
+                    size_t begin = 0, end = 0;
+                    if (range->next(begin, end))
+                    {
+                        participant(*range, begin, end);
+                    }
+                });
+            }
+
+            size_t begin = 0, end = 0;
+            if (range->next(begin, end))
+            {
+                participant(*range, begin, end);
+            }
+            range->wait();
+        }
+    }
+
+    //body(i) for every i in [first, last)
+    template<class Index, class F>
+    void parallel_for(WorkerPool& pool, Index first, Index last, F&& body, size_t grain = 0)
+    {
+        if (!(first < last))
+        {
+            return;
+        }
+
+        auto participant = [first, &body](priv::Range& range, size_t begin, size_t end) {
+            size_t processed = 0;
+            do
+            {
+                try
+                {
+                    for (size_t i = begin; i != end; ++i)
+                    {
+                        body(Index(first + i));
+                    }
+                }
+                catch (...)
+                {
+                    range.fail(std::current_exception());
+                }
+                processed += end - begin;
+            } while (range.next(begin, end));
+            range.finished(processed);
+        };
+        priv::run(pool, (size_t)(last - first), grain, participant);
+    }
+
+    //func(item) on every item of a random access range
+    template<class It, class F>
+    void parallel_for_each(WorkerPool& pool, It first, It last, F&& func, size_t grain = 0)
+    {
+        parallel_for(pool, (size_t)0, (size_t)std::distance(first, last), [first, &func](size_t i) {
+            func(*(first + i));
+        }, grain);
+    }
+
+    //map(begin, end, init) folds a sub range [begin, end) of indices into init,
+    //reduce(a, b) combines partial results and must be associative and commutative.
+    template<class Index, class T, class Map, class Reduce>
+    T parallel_reduce(WorkerPool& pool, Index first, Index last, T identity, Map&& map, Reduce&& reduce, size_t grain = 0)
+    {
+        if (!(first < last))
+        {
+            return identity;
+        }
+
+        std::mutex lock;
+        T result = identity;
+        auto participant = [&](priv::Range& range, size_t begin, size_t end) {
+            size_t processed = 0;
+            T partial = identity;
+            try
+            {
+                do
+                {
+                    processed += end - begin;
+                    partial = map(Index(first + begin), Index(first + end), std::move(partial));
+                } while (range.next(begin, end));
+
+                std::lock_guard<std::mutex> guard(lock);
+                result = reduce(std::move(result), std::move(partial));
+            }
+            catch (...)
+            {
+                //drain the rest so the caller is not left waiting
+                range.fail(std::current_exception());
+                while (range.next(begin, end))
+                {
+                    processed += end - begin;
+                }
+            }
+            range.finished(processed);
+        };
+        priv::run(pool, (size_t)(last - first), grain, participant);
+        return result;
+    }
+
+    //merge sort: blocks are sorted in parallel, then merged pairwise in parallel rounds
+    template<class It, class Compare = std::less<>>
+    void parallel_sort(WorkerPool& pool, It first, It last, Compare comp = Compare())
+    {
+        using T = typename std::iterator_traits<It>::value_type;
+        const size_t kSerialSort = 1 << 14;
+
+        const size_t count = (size_t)std::distance(first, last);
+        if (count <= kSerialSort || pool.size() == 0)
+        {
+            std::sort(first, last, comp);
+            return;
+        }
+
+        size_t blocks = 1;
+        while (blocks < (pool.size() + 1) * 2 && count / (blocks * 2) >= kSerialSort)
+        {
+            blocks <<= 1;
+        }
+        const size_t blockSize = (count + blocks - 1) / blocks;
+
+        std::vector<T> buffer(std::make_move_iterator(first), std::make_move_iterator(last));
+        parallel_for(pool, (size_t)0, blocks, [&](size_t block) {
+            auto begin = buffer.begin() + std::min(count, block * blockSize);
+            auto end = buffer.begin() + std::min(count, (block + 1) * blockSize);
+            std::sort(begin, end, comp);
+        }, 1);
+
+        auto mergeRound = [&](auto src, auto dst, size_t width) {
+            size_t pairs = (count + width * 2 - 1) / (width * 2);
+            parallel_for(pool, (size_t)0, pairs, [&](size_t pair) {
+                size_t lo = pair * width * 2;
+                size_t mid = std::min(count, lo + width);
+                size_t hi = std::min(count, lo + width * 2);
+                std::merge(std::make_move_iterator(src + lo), std::make_move_iterator(src + mid),
+                    std::make_move_iterator(src + mid), std::make_move_iterator(src + hi),
+                    dst + lo, comp);
+            }, 1);
+        };
+
+        bool inBuffer = true;
+        for (size_t width = blockSize; width < count; width *= 2)
+        {
+            if (inBuffer)
+            {
+                mergeRound(buffer.begin(), first, width);
+            }
+            else
+            {
+                mergeRound(first, buffer.begin(), width);
+            }
+            inBuffer = !inBuffer;
+        }
+
+        if (inBuffer)
+        {
+            std::move(buffer.begin(), buffer.end(), first);
+        }
+    }
+}
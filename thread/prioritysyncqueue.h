@@ -0,0 +1,263 @@
+#pragma once
+
+enum class TaskPriority
+{
+    High,
+    Normal,
+    Background,
+};
+
+//SyncQueue with one FIFO lane per TaskPriority.
+//higher lanes go first, unless the head of a lower lane has waited longer than the starvation limit.
+//items may carry a deadline, expired items are dropped at dequeue instead of being handed out.
+template<class T>
+class PrioritySyncQueue
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int kLanes = 3;
+
+    struct LaneStats
+    {
+        size_t depth = 0;
+        uint64_t enqueued = 0;
+        uint64_t dequeued = 0;
+        uint64_t expired = 0;
+        uint64_t totalWaitMicros = 0;
+        uint64_t maxWaitMicros = 0;
+
+        double averageWaitMicros() const
+        {
+            return dequeued ? (double)totalWaitMicros / dequeued : 0.0;
+        }
+    };
+
+private:
+    struct Item
+    {
+        T item;
+        Clock::time_point enqueued;
+        Clock::time_point deadline;
+    };
+
+    struct Lane
+    {
+        std::deque<Item> queue;
+        LaneStats stats;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    Lane lanes_[kLanes];
+    std::atomic<size_t> size_ = 0;
+    std::chrono::microseconds starvationLimit_ = std::chrono::milliseconds(100);
+    bool stop_ = false;
+
+    PrioritySyncQueue(const PrioritySyncQueue&) = delete;
+    PrioritySyncQueue &operator=(const PrioritySyncQueue &) = delete;
+
+public:
+    PrioritySyncQueue() = default;
+    ~PrioritySyncQueue();
+
+    void start();
+    void stop();
+
+    bool isEmpty();
+    size_t size() const;
+
+    void setStarvationLimit(std::chrono::microseconds limit);
+
+    //a default constructed deadline means none
+    void enqueue(T&& item, TaskPriority priority = TaskPriority::Normal, Clock::time_point deadline = Clock::time_point());
+    template<class It> void enqueueBulk(It first, It last, TaskPriority priority = TaskPriority::Normal);
+
+    //only takes from lanes High down to lowest, unless a lower lane is starving
+    bool try_dequeue(T& item, TaskPriority lowest = TaskPriority::Background);
+    bool dequeue(T& item);
+    //also gives up once timeout passes without an item
+    bool dequeue(T& item, std::chrono::microseconds timeout);
+
+    LaneStats stats(TaskPriority priority);
+
+private:
+    bool take(T& item, TaskPriority lowest, std::vector<T>& expired);
+};
+
+template<class T> PrioritySyncQueue<T>::~PrioritySyncQueue()
+{
+    stop();
+}
+
+template<class T> void PrioritySyncQueue<T>::start()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_ = false;
+}
+
+template<class T> void PrioritySyncQueue<T>::stop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_ = true;
+    cv_.notify_all();
+}
+
+template<class T> bool PrioritySyncQueue<T>::isEmpty()
+{
+    return size_ == 0;
+}
+
+template<class T> size_t PrioritySyncQueue<T>::size() const
+{
+    return size_;
+}
+
+template<class T> void PrioritySyncQueue<T>::setStarvationLimit(std::chrono::microseconds limit)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    starvationLimit_ = limit;
+}
+
+template<class T> void PrioritySyncQueue<T>::enqueue(T&& item, TaskPriority priority, Clock::time_point deadline)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Lane& lane = lanes_[(int)priority];
+        lane.queue.push_back(Item{ std::move(item), Clock::now(), deadline });
+        lane.stats.enqueued += 1;
+        size_ += 1;
+    }
+
+    cv_.notify_one();
+}
+
+template<class T> template<class It> void PrioritySyncQueue<T>::enqueueBulk(It first, It last, TaskPriority priority)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Lane& lane = lanes_[(int)priority];
+        auto now = Clock::now();
+        size_t count = 0;
+        for (; first != last; ++first, ++count)
+        {
+            lane.queue.push_back(Item{ std::move(*first), now, Clock::time_point() });
+        }
+        lane.stats.enqueued += count;
+        size_ += count;
+    }
+
+    cv_.notify_all();
+}
+
+template<class T> bool PrioritySyncQueue<T>::try_dequeue(T& item, TaskPriority lowest)
+{
+    std::vector<T> expired;
+    std::unique_lock<std::mutex> lock(mutex_);
+    return take(item, lowest, expired);
+}
+
+template<class T> bool PrioritySyncQueue<T>::dequeue(T& item)
+{
+    //expired items are destroyed after the lock is released
+    std::vector<T> expired;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        if (stop_)
+        {
+            return false;
+        }
+        if (take(item, TaskPriority::Background, expired))
+        {
+            return true;
+        }
+        cv_.wait(lock);
+    }
+}
+
+template<class T> bool PrioritySyncQueue<T>::dequeue(T& item, std::chrono::microseconds timeout)
+{
+    std::vector<T> expired;
+    auto until = Clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        if (stop_)
+        {
+            return false;
+        }
+        if (take(item, TaskPriority::Background, expired))
+        {
+            return true;
+        }
+        if (cv_.wait_until(lock, until) == std::cv_status::timeout)
+        {
+            return !stop_ && take(item, TaskPriority::Background, expired);
+        }
+    }
+}
+
+template<class T> typename PrioritySyncQueue<T>::LaneStats PrioritySyncQueue<T>::stats(TaskPriority priority)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    const Lane& lane = lanes_[(int)priority];
+    LaneStats stats = lane.stats;
+    stats.depth = lane.queue.size();
+    return stats;
+}
+
+template<class T> bool PrioritySyncQueue<T>::take(T& item, TaskPriority lowest, std::vector<T>& expired)
+{
+    auto now = Clock::now();
+    while (true)
+    {
+        int lane = -1;
+        int starving = -1;
+        for (int i = 0; i != kLanes; ++i)
+        {
+            const auto& queue = lanes_[i].queue;
+            if (queue.empty())
+            {
+                continue;
+            }
+            if (lane < 0 && i <= (int)lowest)
+            {
+                lane = i;
+            }
+            if (now - queue.front().enqueued > starvationLimit_
+                && (starving < 0 || queue.front().enqueued < lanes_[starving].queue.front().enqueued))
+            {
+                starving = i;
+            }
+        }
+
+        if (starving >= 0)
+        {
+            lane = starving;
+        }
+        if (lane < 0)
+        {
+            return false;
+        }
+
+        Lane& chosen = lanes_[lane];
+        Item front = std::move(chosen.queue.front());
+        chosen.queue.pop_front();
+        size_ -= 1;
+
+        if (front.deadline != Clock::time_point() && now > front.deadline)
+        {
+            chosen.stats.expired += 1;
+            expired.push_back(std::move(front.item));
+            continue;
+        }
+
+        uint64_t wait = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - front.enqueued).count();
+        chosen.stats.dequeued += 1;
+        chosen.stats.totalWaitMicros += wait;
+        chosen.stats.maxWaitMicros = std::max(chosen.stats.maxWaitMicros, wait);
+
+        item = std::move(front.item);
+        return true;
+    }
+}
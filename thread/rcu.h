@@ -0,0 +1,231 @@
+#pragma once
+
+//epoch based read-copy-update.
+//readers mark a critical section with a store to their own cache line, no lock and no shared write.
+//writers publish a new version, then retire the old one, it is deleted once every reader
+//that could still see it left its section. nothing ever blocks, retired versions wait
+//in a list that is reclaimed on later retires and when a reader leaves its outermost section.
+//
+//  //reader
+//  Rcu::ReadGuard guard;
+//  const Table* table = table_.load(std::memory_order_acquire);
+//
+//  //writer, serialized by its own lock
+//  Table* old = table_.exchange(new Table(*old), std::memory_order_acq_rel);
+//  Rcu::retire(old);
+class Rcu
+{
+    struct alignas(64) Reader
+    {
+        //epoch the outermost section started in, 0 outside any section
+        std::atomic<uint64_t> epoch = 0;
+        std::atomic<bool> inUse = true;
+        //only touched by the owning thread
+        uint32_t depth = 0;
+        Reader* next = nullptr;
+    };
+
+    struct Retired
+    {
+        uint64_t epoch;
+        void* ptr;
+        void(*deleter)(void*);
+    };
+
+    //releases the thread's reader slot for the next new thread
+    struct ThreadSlot
+    {
+        Reader* reader = nullptr;
+
+        ~ThreadSlot()
+        {
+            if (reader)
+            {
+                reader->inUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    std::atomic<uint64_t> epoch_ = 1;
+    std::atomic<Reader*> readers_ = nullptr;
+    std::mutex retireLock_;
+    std::vector<Retired> retired_;
+    //retired_.size(), for readers to check without the lock
+    std::atomic<size_t> pending_ = 0;
+
+    Rcu() = default;
+
+    static Rcu& instance();
+    static Reader* localReader();
+
+    Reader* acquireReader();
+    void retire(void* ptr, void(*deleter)(void*));
+    uint64_t oldestActiveEpoch() const;
+    void reclaim(std::unique_lock<std::mutex>& lock);
+
+public:
+    class ReadGuard
+    {
+        Reader* reader_;
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    public:
+        ReadGuard();
+        ~ReadGuard();
+    };
+
+    //deletes ptr once no reader can reach it any more, call after unpublishing it
+    template<class T>
+    static void retire(T* ptr);
+
+    //deletes whatever retired versions became unreachable
+    static void reclaim();
+
+    static size_t retiredCount();
+};
+
+//if build this as a dynamic library make sure put this function into cpp source file
+inline Rcu& Rcu::instance()
+{
+    //never destroyed, static objects may still retire while the process exits
+    static Rcu* rcu = new Rcu();
+    return *rcu;
+}
+
+inline Rcu::Reader* Rcu::localReader()
+{
+    static thread_local ThreadSlot slot;
+    if (!slot.reader)
+    {
+        slot.reader = instance().acquireReader();
+    }
+    return slot.reader;
+}
+
+//reader slots are never freed, a thread takes over the slot of an exited one
+inline Rcu::Reader* Rcu::acquireReader()
+{
+    for (Reader* reader = readers_.load(std::memory_order_acquire); reader; reader = reader->next)
+    {
+        bool inUse = false;
+        if (!reader->inUse.load(std::memory_order_relaxed)
+            && reader->inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+        {
+            return reader;
+        }
+    }
+
+    Reader* reader = new Reader();
+    Reader* head = readers_.load(std::memory_order_relaxed);
+    do
+    {
+        reader->next = head;
+    } while (!readers_.compare_exchange_weak(head, reader, std::memory_order_release, std::memory_order_relaxed));
+    return reader;
+}
+
+inline Rcu::ReadGuard::ReadGuard()
+    : reader_(localReader())
+{
+    if (reader_->depth++ == 0)
+    {
+        //acquire pairs with the epoch bump in retire, whatever was unpublished before it is invisible now
+        reader_->epoch.store(instance().epoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+        //the announcement must be visible before this section reads any published pointer
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+inline Rcu::ReadGuard::~ReadGuard()
+{
+    if (--reader_->depth == 0)
+    {
+        reader_->epoch.store(0, std::memory_order_release);
+        //this reader may have been the last one holding a retired version back.
+        //a stale zero only defers it to the next reader or retire
+        Rcu& self = instance();
+        if (self.pending_.load(std::memory_order_relaxed) != 0)
+        {
+            //never wait on a writer that is reclaiming already
+            std::unique_lock<std::mutex> lock(self.retireLock_, std::try_to_lock);
+            if (lock.owns_lock())
+            {
+                self.reclaim(lock);
+            }
+        }
+    }
+}
+
+template<class T>
+void Rcu::retire(T* ptr)
+{
+    instance().retire(ptr, [](void* p) {
+        delete static_cast<T*>(p);
+    });
+}
+
+inline void Rcu::retire(void* ptr, void(*deleter)(void*))
+{
+    //readers that start from now on announce a newer epoch and can not see ptr
+    uint64_t epoch = epoch_.fetch_add(1, std::memory_order_acq_rel);
+    {
+        std::lock_guard<std::mutex> lock(retireLock_);
+        retired_.push_back(Retired{ epoch, ptr, deleter });
+        pending_.store(retired_.size(), std::memory_order_relaxed);
+    }
+    reclaim();
+}
+
+inline uint64_t Rcu::oldestActiveEpoch() const
+{
+    //pairs with the reader's fence: either we see its announcement or it sees the new version
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest = UINT64_MAX;
+    for (Reader* reader = readers_.load(std::memory_order_acquire); reader; reader = reader->next)
+    {
+        uint64_t epoch = reader->epoch.load(std::memory_order_acquire);
+        if (epoch != 0 && epoch < oldest)
+        {
+            oldest = epoch;
+        }
+    }
+    return oldest;
+}
+
+inline void Rcu::reclaim()
+{
+    Rcu& self = instance();
+    std::unique_lock<std::mutex> lock(self.retireLock_);
+    self.reclaim(lock);
+}
+
+//unlocks before running the deleters, they may retire again
+inline void Rcu::reclaim(std::unique_lock<std::mutex>& lock)
+{
+    std::vector<Retired> ready;
+    if (retired_.empty())
+    {
+        return;
+    }
+    uint64_t oldest = oldestActiveEpoch();
+    auto split = std::partition(retired_.begin(), retired_.end(), [oldest](const Retired& retired) {
+        return retired.epoch >= oldest;
+    });
+    ready.assign(split, retired_.end());
+    retired_.erase(split, retired_.end());
+    pending_.store(retired_.size(), std::memory_order_relaxed);
+    lock.unlock();
+    for (auto& retired : ready)
+    {
+        retired.deleter(retired.ptr);
+    }
+}
+
+inline size_t Rcu::retiredCount()
+{
+    Rcu& self = instance();
+    std::lock_guard<std::mutex> lock(self.retireLock_);
+    return self.retired_.size();
+}
@@ -1 +1,326 @@
 #pragma once
+
+//reader writer locks, all of them work with std::unique_lock / std::lock_guard,
+//RWSpinLock and ShardedRWLock also with std::shared_lock.
+
+namespace priv
+{
+    inline void cpuRelax()
+    {
+#if defined(_MSC_VER)
+        YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    //pause for a while, then start giving the cpu away
+    class SpinBackoff
+    {
+        int count_ = 0;
+    public:
+        void pause()
+        {
+            if (count_ < 64)
+            {
+                count_ += 1;
+                cpuRelax();
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    };
+}
+
+//writer preferring reader writer spin lock in one word.
+//a waiting writer raises the pending bit so new readers back off until it got the lock.
+class RWSpinLock
+{
+    enum : uint32_t
+    {
+        kWriter = 1,
+        kPending = 2,
+        kReader = 4,
+    };
+
+    std::atomic<uint32_t> state_ = 0;
+
+    RWSpinLock(const RWSpinLock&) = delete;
+    RWSpinLock& operator=(const RWSpinLock&) = delete;
+
+public:
+    RWSpinLock() = default;
+
+    void lock()
+    {
+        priv::SpinBackoff backoff;
+        uint32_t state = state_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            if ((state & ~kPending) == 0)
+            {
+                if (state_.compare_exchange_weak(state, kWriter, std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    return;
+                }
+                continue;
+            }
+            if ((state & kPending) == 0)
+            {
+                state_.fetch_or(kPending, std::memory_order_relaxed);
+            }
+            backoff.pause();
+            state = state_.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool try_lock()
+    {
+        uint32_t state = state_.load(std::memory_order_relaxed);
+        return (state & ~kPending) == 0
+            && state_.compare_exchange_strong(state, kWriter, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock()
+    {
+        state_.fetch_and(~kWriter, std::memory_order_release);
+    }
+
+    void lock_shared()
+    {
+        priv::SpinBackoff backoff;
+        while (!try_lock_shared())
+        {
+            backoff.pause();
+        }
+    }
+
+    bool try_lock_shared()
+    {
+        uint32_t state = state_.load(std::memory_order_relaxed);
+        while ((state & (kWriter | kPending)) == 0)
+        {
+            if (state_.compare_exchange_weak(state, state + kReader, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void unlock_shared()
+    {
+        state_.fetch_sub(kReader, std::memory_order_release);
+    }
+};
+
+//reader counts are sharded over cache line padded slots so readers on different threads
+//never touch the same line, a writer sets its flag and waits for every slot to drain.
+//a thread keeps its slot for life, so lock_shared / unlock_shared must happen on the same thread.
+class ShardedRWLock
+{
+    struct alignas(64) Shard
+    {
+        std::atomic<int> readers = 0;
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<bool> writer_ = false;
+
+    ShardedRWLock(const ShardedRWLock&) = delete;
+    ShardedRWLock& operator=(const ShardedRWLock&) = delete;
+
+    static size_t threadSlot()
+    {
+        static std::atomic<size_t> next = 0;
+        static thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+
+    Shard& shard()
+    {
+        return shards_[threadSlot() & mask_];
+    }
+
+public:
+    explicit ShardedRWLock(size_t shards = std::thread::hardware_concurrency())
+    {
+        size_t size = 1;
+        while (size < shards)
+        {
+            size <<= 1;
+        }
+        shards_.reset(new Shard[size]);
+        mask_ = size - 1;
+    }
+
+    void lock()
+    {
+        priv::SpinBackoff backoff;
+        while (writer_.exchange(true, std::memory_order_seq_cst))
+        {
+            backoff.pause();
+        }
+        for (size_t i = 0; i <= mask_; ++i)
+        {
+            while (shards_[i].readers.load(std::memory_order_seq_cst) != 0)
+            {
+                backoff.pause();
+            }
+        }
+    }
+
+    bool try_lock()
+    {
+        if (writer_.exchange(true, std::memory_order_seq_cst))
+        {
+            return false;
+        }
+        for (size_t i = 0; i <= mask_; ++i)
+        {
+            if (shards_[i].readers.load(std::memory_order_seq_cst) != 0)
+            {
+                writer_.store(false, std::memory_order_release);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void unlock()
+    {
+        writer_.store(false, std::memory_order_release);
+    }
+
+    void lock_shared()
+    {
+        priv::SpinBackoff backoff;
+        while (!try_lock_shared())
+        {
+            backoff.pause();
+        }
+    }
+
+    bool try_lock_shared()
+    {
+        Shard& slot = shard();
+        if (writer_.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        //pairs with the writer: either it sees our count or we see its flag
+        slot.readers.fetch_add(1, std::memory_order_seq_cst);
+        if (!writer_.load(std::memory_order_seq_cst))
+        {
+            return true;
+        }
+        slot.readers.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    void unlock_shared()
+    {
+        shard().readers.fetch_sub(1, std::memory_order_release);
+    }
+};
+
+//sequence lock, writers take it like a mutex, readers never write shared memory:
+//they read optimistically and retry when a writer got in between.
+//readers can not block writers, so there is no lock_shared, use read_begin / read_retry or SeqLocked.
+class SeqLock
+{
+    std::atomic<uint32_t> sequence_ = 0;
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+public:
+    SeqLock() = default;
+
+    void lock()
+    {
+        priv::SpinBackoff backoff;
+        while (!try_lock())
+        {
+            backoff.pause();
+        }
+    }
+
+    bool try_lock()
+    {
+        uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        if ((sequence & 1) == 0
+            && sequence_.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            std::atomic_thread_fence(std::memory_order_release);
+            return true;
+        }
+        return false;
+    }
+
+    void unlock()
+    {
+        sequence_.fetch_add(1, std::memory_order_release);
+    }
+
+    uint32_t read_begin() const
+    {
+        priv::SpinBackoff backoff;
+        uint32_t sequence = sequence_.load(std::memory_order_acquire);
+        while (sequence & 1)
+        {
+            backoff.pause();
+            sequence = sequence_.load(std::memory_order_acquire);
+        }
+        return sequence;
+    }
+
+    bool read_retry(uint32_t sequence) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence_.load(std::memory_order_relaxed) != sequence;
+    }
+};
+
+//small trivially copyable value guarded by a SeqLock, load() returns a consistent snapshot
+template<class T>
+class SeqLocked
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLocked needs a trivially copyable type");
+
+    mutable SeqLock lock_;
+    T value_;
+
+public:
+    SeqLocked() : value_() {}
+    explicit SeqLocked(const T& value) : value_(value) {}
+
+    T load() const
+    {
+        T result;
+        uint32_t sequence = 0;
+        do
+        {
+            sequence = lock_.read_begin();
+            std::memcpy(&result, &value_, sizeof(T));
+        } while (lock_.read_retry(sequence));
+        return result;
+    }
+
+    void store(const T& value)
+    {
+        std::lock_guard<SeqLock> guard(lock_);
+        std::memcpy(&value_, &value, sizeof(T));
+    }
+
+    //func(T&) modifies the value in place under the write lock
+    template<class F>
+    void update(F&& func)
+    {
+        std::lock_guard<SeqLock> guard(lock_);
+        func(value_);
+    }
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "workerpool.h"
+
+//serial executor on top of a WorkerPool: tasks run in FIFO order, never two at a time,
+//on whichever pool thread picks the strand up. no thread is blocked waiting for the strand,
+//posting is a lock free push and only the post that finds the strand idle schedules it.
+class Strand : public Executor
+{
+    struct Node
+    {
+        std::atomic<Node*> next = nullptr;
+        Task task;
+    };
+
+    //multi producer single consumer queue with a stub node, pending counts pushed tasks
+    struct State : std::enable_shared_from_this<State>
+    {
+        WorkerPool* pool;
+        std::atomic<Node*> head;
+        Node* tail;
+        std::atomic<size_t> pending = 0;
+
+        explicit State(WorkerPool* pool);
+        ~State();
+
+        void push(Task&& task);
+        Task pop();
+        bool schedule();
+        void drain();
+    };
+
+    //tasks run per pool visit before the strand yields its thread to others
+    static constexpr size_t kBatch = 64;
+
+    std::shared_ptr<State> state_;
+
+    static const State*& current();
+
+public:
+    explicit Strand(WorkerPool* pool = WorkerPool::pool());
+
+    //queued tasks still run after the strand itself is gone, on a stopped pool they run on the posting thread
+    void post(Task&& task) override;
+
+    bool runningInThisThread() const;
+    size_t pending() const;
+};
+
+inline Strand::State::State(WorkerPool* pool)
+    : pool(pool)
+    , head(new Node())
+    , tail(head.load())
+{
+}
+
+inline Strand::State::~State()
+{
+    while (Node* next = tail->next.load(std::memory_order_acquire))
+    {
+        delete tail;
+        tail = next;
+    }
+    delete tail;
+}
+
+inline void Strand::State::push(Task&& task)
+{
+    Node* node = new Node();
+    node->task = std::move(task);
+    Node* prev = head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+//only called by the one drain in flight, for a counted task
+inline Task Strand::State::pop()
+{
+    Node* next = tail->next.load(std::memory_order_acquire);
+    while (!next)
+    {
+        //a producer swapped head but has not linked its node yet
+        std::this_thread::yield();
+        next = tail->next.load(std::memory_order_acquire);
+    }
+    Task task = std::move(next->task);
+    delete tail;
+    tail = next;
+    return task;
+}
+
+//false when the pool is stopped, pending stays above zero then and the caller drains on its own
+//thread, otherwise no later post would schedule the strand again
+inline bool Strand::State::schedule()
+{
+    return pool->tryAdd([self = shared_from_this()]() {
+        self->drain();
+    });
+}
+
+inline void Strand::State::drain()
+{
+    const State* outer = current();
+    current() = this;
+
+    for (;;)
+    {
+        size_t count = std::min(pending.load(std::memory_order_acquire), kBatch);
+        for (size_t i = 0; i != count; ++i)
+        {
+            Task task = pop();
+            task();
+        }
+
+        //whoever brings pending to zero ends the drain, tasks posted meanwhile go in a new visit
+        if (pending.fetch_sub(count, std::memory_order_acq_rel) == count || schedule())
+        {
+            break;
+        }
+    }
+
+    current() = outer;
+}
+
+inline const Strand::State*& Strand::current()
+{
+    static thread_local const State* state = nullptr;
+    return state;
+}
+
+inline Strand::Strand(WorkerPool* pool /*= WorkerPool::pool()*/)
+    : state_(std::make_shared<State>(pool))
+{
+}
+
+inline void Strand::post(Task&& task)
+{
+    state_->push(std::move(task));
+    if (state_->pending.fetch_add(1, std::memory_order_acq_rel) == 0 && !state_->schedule())
+    {
+        state_->drain();
+    }
+}
+
+inline bool Strand::runningInThisThread() const
+{
+    return current() == state_.get();
+}
+
+inline size_t Strand::pending() const
+{
+    return state_->pending.load(std::memory_order_relaxed);
+}
@@ -5,7 +5,9 @@ class SyncQueue
 {
     std::mutex mutex_;
     std::condition_variable cv_;
-    std::deque<T> queue_;
+    //items are [head_, size()), a vector keeps its capacity when emptied or swapped
+    std::vector<T> queue_;
+    size_t head_ = 0;
     bool stop_ = false;
 
     SyncQueue(const SyncQueue&) = delete;
@@ -22,6 +24,7 @@ public:
 
     void enqueue(const T& item);
     void enqueue(T&& item);
+    template<class It> void enqueueBulk(It first, It last);
 
     bool try_dequeue(T& item);
     bool try_dequeueAll(std::deque<T>& items);
@@ -29,6 +32,23 @@ public:
     bool dequeue(T& item);
     bool dequeueAll(std::deque<T>& items);
 
+    //swap the queue with buffer, which is cleared first: one lock and no per item moves.
+    //producers refill buffer's storage, so a consumer swapping the same buffer back and forth
+    //stops allocating once both have grown to the usual batch size.
+    bool try_swapAll(std::vector<T>& buffer);
+    bool swapAll(std::vector<T>& buffer);
+
+    //append at most n items to out, returns how many, 0 on an empty or stopped queue
+    size_t try_dequeue_up_to(size_t n, std::vector<T>& out);
+    size_t dequeue_up_to(size_t n, std::vector<T>& out);
+
+private:
+    bool empty() const;
+    bool wait(std::unique_lock<std::mutex>& lock);
+    size_t take(size_t n, std::vector<T>& out);
+    void moveAll(std::deque<T>& items);
+    void popped();
+
 };
 
 template<class T> SyncQueue<T>::~SyncQueue()
@@ -52,7 +72,7 @@ template<class T> void SyncQueue<T>::stop()
 template<class T> bool SyncQueue<T>::isEmpty()
 {
     std::unique_lock<std::mutex> lock(mutex_);
-    return queue_.empty();
+    return empty();
 }
 
 template<class T> void SyncQueue<T>::enqueue(const T& item)
@@ -75,62 +95,161 @@ template<class T> void SyncQueue<T>::enqueue(T&& item)
     cv_.notify_one();
 }
 
+//moves [first, last) in under one lock and wakes every waiter once
+template<class T> template<class It> void SyncQueue<T>::enqueueBulk(It first, It last)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (; first != last; ++first)
+        {
+            queue_.push_back(std::move(*first));
+        }
+    }
+
+    cv_.notify_all();
+}
+
 template<class T> bool SyncQueue<T>::try_dequeue(T& item)
 {
     std::unique_lock<std::mutex> lock(mutex_);
-    if (queue_.empty())
+    if (empty())
     {
         return false;
     }
 
-    item = std::move(queue_.front());
-    queue_.pop_front();
+    item = std::move(queue_[head_++]);
+    popped();
     return true;
 }
 
 template<class T> bool SyncQueue<T>::try_dequeueAll(std::deque<T>& items)
 {
     std::unique_lock<std::mutex> lock(mutex_);
-    if (queue_.empty())
+    if (empty())
     {
         return false;
     }
 
-    items = std::move(queue_);
+    moveAll(items);
     return true;
 }
 
 template<class T> bool SyncQueue<T>::dequeue(T& item)
 {
     std::unique_lock<std::mutex> lock(mutex_);
-    while (queue_.empty() && !stop_)
+    if (!wait(lock))
     {
-        cv_.wait(lock);
+        return false;
     }
 
-    if (stop_)
+    item = std::move(queue_[head_++]);
+    popped();
+    return true;
+}
+
+template<class T> bool SyncQueue<T>::dequeueAll(std::deque<T>& items)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!wait(lock))
     {
         return false;
     }
 
-    item = std::move(queue_.front());
-    queue_.pop_front();
+    moveAll(items);
     return true;
 }
 
-template<class T> bool SyncQueue<T>::dequeueAll(std::deque<T>& items)
+template<class T> bool SyncQueue<T>::try_swapAll(std::vector<T>& buffer)
 {
+    buffer.clear();
     std::unique_lock<std::mutex> lock(mutex_);
-    while (queue_.empty() && !stop_)
+    if (empty())
     {
-        cv_.wait(lock);
+        return false;
     }
 
-    if (stop_)
+    //items already taken one by one sit in front, rare when a consumer only swaps
+    queue_.erase(queue_.begin(), queue_.begin() + head_);
+    head_ = 0;
+    queue_.swap(buffer);
+    return true;
+}
+
+template<class T> bool SyncQueue<T>::swapAll(std::vector<T>& buffer)
+{
+    buffer.clear();
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!wait(lock))
     {
         return false;
     }
 
-    items = std::move(queue_);
+    queue_.erase(queue_.begin(), queue_.begin() + head_);
+    head_ = 0;
+    queue_.swap(buffer);
     return true;
-}
\ No newline at end of file
+}
+
+template<class T> size_t SyncQueue<T>::try_dequeue_up_to(size_t n, std::vector<T>& out)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return take(n, out);
+}
+
+template<class T> size_t SyncQueue<T>::dequeue_up_to(size_t n, std::vector<T>& out)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (n == 0 || !wait(lock))
+    {
+        return 0;
+    }
+
+    return take(n, out);
+}
+
+template<class T> bool SyncQueue<T>::empty() const
+{
+    return head_ == queue_.size();
+}
+
+template<class T> bool SyncQueue<T>::wait(std::unique_lock<std::mutex>& lock)
+{
+    while (empty() && !stop_)
+    {
+        cv_.wait(lock);
+    }
+
+    return !stop_;
+}
+
+template<class T> size_t SyncQueue<T>::take(size_t n, std::vector<T>& out)
+{
+    size_t count = std::min(n, queue_.size() - head_);
+    auto first = queue_.begin() + head_;
+    out.insert(out.end(), std::make_move_iterator(first), std::make_move_iterator(first + count));
+    head_ += count;
+    popped();
+    return count;
+}
+
+template<class T> void SyncQueue<T>::moveAll(std::deque<T>& items)
+{
+    items.assign(std::make_move_iterator(queue_.begin() + head_), std::make_move_iterator(queue_.end()));
+    queue_.clear();
+    head_ = 0;
+}
+
+//called after head_ moved, drops the taken items once they are half of the storage
+template<class T> void SyncQueue<T>::popped()
+{
+    if (head_ == queue_.size())
+    {
+        queue_.clear();
+        head_ = 0;
+    }
+    else if (head_ >= 32 && head_ * 2 >= queue_.size())
+    {
+        queue_.erase(queue_.begin(), queue_.begin() + head_);
+        head_ = 0;
+    }
+}
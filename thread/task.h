@@ -0,0 +1,136 @@
+#pragma once
+
+//move only void() callable, functors up to kInlineSize bytes are stored inline
+//so posting a typical lambda to WorkerPool does not allocate.
+class Task
+{
+public:
+    static constexpr size_t kInlineSize = 64;
+
+private:
+    struct Ops
+    {
+        void(*invoke)(void* storage);
+        void(*move)(void* dst, void* src);
+        void(*destroy)(void* storage);
+    };
+
+    template<class F>
+    struct InlineOps
+    {
+        static F* get(void* storage) { return static_cast<F*>(storage); }
+
+        static void invoke(void* storage) { (*get(storage))(); }
+        static void move(void* dst, void* src)
+        {
+            new (dst) F(std::move(*get(src)));
+            get(src)->~F();
+        }
+        static void destroy(void* storage) { get(storage)->~F(); }
+
+        static constexpr Ops ops = { &invoke, &move, &destroy };
+    };
+
+    template<class F>
+    struct HeapOps
+    {
+        static F*& get(void* storage) { return *static_cast<F**>(storage); }
+
+        static void invoke(void* storage) { (*get(storage))(); }
+        static void move(void* dst, void* src)
+        {
+            new (dst) F*(get(src));
+            get(src) = nullptr;
+        }
+        static void destroy(void* storage) { delete get(storage); }
+
+        static constexpr Ops ops = { &invoke, &move, &destroy };
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const Ops* ops_ = nullptr;
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+public:
+    template<class F>
+    static constexpr bool isInline()
+    {
+        return sizeof(F) <= kInlineSize
+            && alignof(std::max_align_t) % alignof(F) == 0
+            && std::is_nothrow_move_constructible<F>::value;
+    }
+
+    Task() = default;
+
+    Task(std::nullptr_t)
+    {
+    }
+
+    template<class F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value, bool>>
+    Task(F&& func)
+    {
+        using Fn = std::decay_t<F>;
+        if constexpr (isInline<Fn>())
+        {
+            new (storage_) Fn(std::forward<F>(func));
+            ops_ = &InlineOps<Fn>::ops;
+        }
+        else
+        {
+            new (storage_) Fn*(new Fn(std::forward<F>(func)));
+            ops_ = &HeapOps<Fn>::ops;
+        }
+    }
+
+    Task(Task&& other) noexcept
+    {
+        if (other.ops_)
+        {
+            other.ops_->move(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            if (other.ops_)
+            {
+                other.ops_->move(storage_, other.storage_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    ~Task()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        if (ops_)
+        {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const
+    {
+        return ops_ != nullptr;
+    }
+
+    void operator()()
+    {
+        assert(ops_);
+        ops_->invoke(storage_);
+    }
+};
@@ -0,0 +1,420 @@
+#pragma once
+
+#include "workerpool.h"
+
+//hierarchical timing wheel: 4 levels of 256 slots, level n slots are 256^n ticks wide.
+//insert and cancel are O(1), a tick thread expires slots and hands the tasks to a WorkerPool.
+//timers are never early, they fire on the first tick at or after their delay.
+class TimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //refers to one scheduled timer, stays safe to use after the timer fired or was cancelled,
+    //but must not outlive its wheel
+    class Handle
+    {
+        friend class TimerWheel;
+        TimerWheel* wheel_ = nullptr;
+        uint32_t index_ = 0;
+        uint32_t generation_ = 0;
+
+        Handle(TimerWheel* wheel, uint32_t index, uint32_t generation)
+            : wheel_(wheel), index_(index), generation_(generation)
+        {
+        }
+
+    public:
+        Handle() = default;
+
+        //true if the timer was still pending and will now never run
+        bool cancel() const
+        {
+            return wheel_ && wheel_->cancel(*this);
+        }
+
+        bool isPending() const
+        {
+            return wheel_ && wheel_->isPending(*this);
+        }
+    };
+
+private:
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 8;
+    static constexpr uint32_t kSlots = 1 << kSlotBits;
+    static constexpr uint32_t kSlotMask = kSlots - 1;
+    static constexpr uint32_t kNil = 0xffffffff;
+    static constexpr uint64_t kMaxDelta = ((uint64_t)1 << (kLevels * kSlotBits)) - 1;
+
+    struct Node
+    {
+        Task task;
+        uint64_t expire = 0;
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+        uint32_t* head = nullptr;
+        uint32_t generation = 0;
+    };
+
+    WorkerPool* pool_;
+    const std::chrono::microseconds tick_;
+    const Clock::time_point start_;
+
+    std::mutex lock_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+
+    //deque keeps nodes in place while it grows, free nodes are chained through next
+    std::deque<Node> nodes_;
+    uint32_t free_ = kNil;
+    uint32_t slots_[kLevels][kSlots];
+    uint64_t current_ = 0;
+    //tick the tick thread sleeps until, a timer due before it has to wake the thread
+    uint64_t wakeTick_ = UINT64_MAX;
+    size_t size_ = 0;
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+public:
+    explicit TimerWheel(WorkerPool* pool = WorkerPool::pool(), std::chrono::microseconds tick = std::chrono::milliseconds(1));
+    ~TimerWheel();
+
+    //default, dispatches into WorkerPool::pool()
+    static TimerWheel* wheel();
+    static Handle asyncDelayed(Task&& task, std::chrono::microseconds delay);
+
+    Handle schedule(Task&& task, std::chrono::microseconds delay);
+    Handle scheduleAt(Task&& task, Clock::time_point when);
+    bool cancel(const Handle& handle);
+    bool isPending(const Handle& handle);
+
+    std::chrono::microseconds tick() const;
+    size_t size();
+
+protected:
+    void threadRun();
+    bool pending(const Handle& handle) const;
+    uint64_t tickOf(Clock::time_point time) const;
+    void insert(uint32_t index);
+    void unlink(uint32_t index);
+    uint32_t allocate();
+    void release(uint32_t index);
+    void cascade(int level);
+    void expire(std::vector<Task>& fired);
+    uint64_t nextTick() const;
+};
+
+inline TimerWheel::TimerWheel(WorkerPool* pool /*= WorkerPool::pool()*/, std::chrono::microseconds tick /*= std::chrono::milliseconds(1)*/)
+    : pool_(pool)
+    , tick_(std::max(tick, std::chrono::microseconds(1)))
+    , start_(Clock::now())
+{
+    for (auto& level : slots_)
+    {
+        std::fill(std::begin(level), std::end(level), kNil);
+    }
+    thread_ = std::thread(&TimerWheel::threadRun, this);
+}
+
+inline TimerWheel::~TimerWheel()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+//if build this as a dynamic library make sure put this function into cpp source file
+inline TimerWheel* TimerWheel::wheel()
+{
+    static TimerWheel wheel;
+    return &wheel;
+}
+
+inline TimerWheel::Handle TimerWheel::asyncDelayed(Task&& task, std::chrono::microseconds delay)
+{
+    return wheel()->schedule(std::move(task), delay);
+}
+
+inline TimerWheel::Handle TimerWheel::schedule(Task&& task, std::chrono::microseconds delay)
+{
+    return scheduleAt(std::move(task), Clock::now() + delay);
+}
+
+inline TimerWheel::Handle TimerWheel::scheduleAt(Task&& task, Clock::time_point when)
+{
+    bool wake = false;
+    Handle handle;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        //an idle wheel has not been ticking, slots are placed relative to current_
+        if (size_ == 0)
+        {
+            current_ = std::max(current_, tickOf(Clock::now()));
+        }
+        uint32_t index = allocate();
+        Node& node = nodes_[index];
+        node.task = std::move(task);
+        node.expire = std::max(tickOf(when), current_);
+        insert(index);
+        size_ += 1;
+        wake = node.expire < wakeTick_;
+        handle = Handle(this, index, node.generation);
+    }
+
+    //the tick thread sleeps until the next tick with work, or without a deadline while the wheel is empty
+    if (wake)
+    {
+        cv_.notify_one();
+    }
+    return handle;
+}
+
+inline bool TimerWheel::cancel(const Handle& handle)
+{
+    Task task;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (!pending(handle))
+        {
+            return false;
+        }
+        unlink(handle.index_);
+        task = std::move(nodes_[handle.index_].task);
+        release(handle.index_);
+        size_ -= 1;
+    }
+    //captures are destroyed outside the lock
+    return true;
+}
+
+inline bool TimerWheel::isPending(const Handle& handle)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return pending(handle);
+}
+
+inline bool TimerWheel::pending(const Handle& handle) const
+{
+    if (handle.wheel_ != this || handle.index_ >= nodes_.size())
+    {
+        return false;
+    }
+    const Node& node = nodes_[handle.index_];
+    return node.generation == handle.generation_ && node.head != nullptr;
+}
+
+inline std::chrono::microseconds TimerWheel::tick() const
+{
+    return tick_;
+}
+
+inline size_t TimerWheel::size()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return size_;
+}
+
+inline void TimerWheel::threadRun()
+{
+    std::vector<Task> fired;
+    std::unique_lock<std::mutex> lock(lock_);
+    while (!stop_)
+    {
+        if (size_ == 0)
+        {
+            wakeTick_ = UINT64_MAX;
+            cv_.wait(lock);
+            continue;
+        }
+
+        //sleep through ticks that have nothing to fire or cascade
+        wakeTick_ = nextTick();
+        assert(wakeTick_ != UINT64_MAX);
+        auto due = start_ + tick_ * wakeTick_;
+        if (Clock::now() < due)
+        {
+            cv_.wait_until(lock, due);
+            continue;
+        }
+
+        //last tick whose start has passed
+        uint64_t now = (uint64_t)(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_).count() / tick_.count());
+        while (size_ != 0)
+        {
+            uint64_t next = nextTick();
+            if (next > now)
+            {
+                break;
+            }
+            //the slots of the ticks skipped over are empty
+            current_ = next;
+            expire(fired);
+        }
+        if (size_ == 0)
+        {
+            current_ = std::max(current_, now + 1);
+        }
+
+        if (!fired.empty())
+        {
+            lock.unlock();
+            pool_->add_bulk(std::move(fired));
+            fired.clear();
+            lock.lock();
+        }
+    }
+}
+
+//first tick that starts at or after time
+inline uint64_t TimerWheel::tickOf(Clock::time_point time) const
+{
+    if (time <= start_)
+    {
+        return 0;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - start_);
+    return (uint64_t)((elapsed.count() + tick_.count() - 1) / tick_.count());
+}
+
+inline void TimerWheel::insert(uint32_t index)
+{
+    Node& node = nodes_[index];
+    //timers further out than the top level reach wait in the top level and are cascaded again
+    uint64_t expire = std::min(node.expire, current_ + kMaxDelta);
+    uint64_t delta = expire - current_;
+
+    int level = 0;
+    while (level != kLevels - 1 && delta >= ((uint64_t)1 << ((level + 1) * kSlotBits)))
+    {
+        level += 1;
+    }
+    uint32_t* head = &slots_[level][(expire >> (level * kSlotBits)) & kSlotMask];
+
+    node.head = head;
+    node.prev = kNil;
+    node.next = *head;
+    if (*head != kNil)
+    {
+        nodes_[*head].prev = index;
+    }
+    *head = index;
+}
+
+inline void TimerWheel::unlink(uint32_t index)
+{
+    Node& node = nodes_[index];
+    if (node.prev != kNil)
+    {
+        nodes_[node.prev].next = node.next;
+    }
+    else
+    {
+        *node.head = node.next;
+    }
+    if (node.next != kNil)
+    {
+        nodes_[node.next].prev = node.prev;
+    }
+    node.head = nullptr;
+    node.prev = node.next = kNil;
+}
+
+inline uint32_t TimerWheel::allocate()
+{
+    if (free_ == kNil)
+    {
+        nodes_.emplace_back();
+        return (uint32_t)(nodes_.size() - 1);
+    }
+    uint32_t index = free_;
+    free_ = nodes_[index].next;
+    nodes_[index].next = kNil;
+    return index;
+}
+
+inline void TimerWheel::release(uint32_t index)
+{
+    Node& node = nodes_[index];
+    node.generation += 1;
+    node.next = free_;
+    free_ = index;
+}
+
+//move every timer of the level slot current_ has reached down to the lower levels
+inline void TimerWheel::cascade(int level)
+{
+    uint32_t* head = &slots_[level][(current_ >> (level * kSlotBits)) & kSlotMask];
+    uint32_t index = *head;
+    *head = kNil;
+    while (index != kNil)
+    {
+        uint32_t next = nodes_[index].next;
+        insert(index);
+        index = next;
+    }
+}
+
+//process tick current_ and advance to the next one
+inline void TimerWheel::expire(std::vector<Task>& fired)
+{
+    for (int level = 1; level != kLevels; ++level)
+    {
+        if ((current_ & (((uint64_t)1 << (level * kSlotBits)) - 1)) != 0)
+        {
+            break;
+        }
+        cascade(level);
+    }
+
+    uint32_t* head = &slots_[0][current_ & kSlotMask];
+    uint32_t index = *head;
+    *head = kNil;
+    while (index != kNil)
+    {
+        Node& node = nodes_[index];
+        uint32_t next = node.next;
+        node.head = nullptr;
+        fired.push_back(std::move(node.task));
+        release(index);
+        size_ -= 1;
+        index = next;
+    }
+    current_ += 1;
+}
+
+//first tick at or after current_ that fires a level 0 slot or cascades a non-empty higher slot
+inline uint64_t TimerWheel::nextTick() const
+{
+    uint64_t next = UINT64_MAX;
+    for (uint32_t i = 0; i != kSlots; ++i)
+    {
+        if (slots_[0][(current_ + i) & kSlotMask] != kNil)
+        {
+            next = current_ + i;
+            break;
+        }
+    }
+
+    for (int level = 1; level != kLevels; ++level)
+    {
+        const int shift = level * kSlotBits;
+        const uint64_t width = (uint64_t)1 << shift;
+        //level slots are cascaded when current_ reaches a multiple of their width
+        uint64_t boundary = (current_ + width - 1) >> shift << shift;
+        for (uint32_t i = 0; i != kSlots && boundary < next; ++i, boundary += width)
+        {
+            if (slots_[level][(boundary >> shift) & kSlotMask] != kNil)
+            {
+                next = boundary;
+                break;
+            }
+        }
+    }
+    return next;
+}
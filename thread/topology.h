@@ -0,0 +1,168 @@
+#pragma once
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+//cpus grouped by NUMA node, falls back to one node holding every cpu
+struct CpuTopology
+{
+    std::vector<std::vector<unsigned int>> nodes;
+
+    static CpuTopology detect();
+
+    unsigned int nodeCount() const;
+    unsigned int cpuCount() const;
+    int nodeOfCpu(unsigned int cpu) const;
+
+    //"0-3,8,10-11" as used by /sys/devices/system/node/nodeN/cpulist
+    static std::vector<unsigned int> parseCpuList(const std::string& list);
+};
+
+bool setThreadAffinity(std::thread::native_handle_type thread, const std::vector<unsigned int>& cpus);
+bool setCurrentThreadAffinity(const std::vector<unsigned int>& cpus);
+
+inline CpuTopology CpuTopology::detect()
+{
+    CpuTopology topology;
+#ifdef _WIN32
+    ULONG highest = 0;
+    if (GetNumaHighestNodeNumber(&highest))
+    {
+        for (ULONG node = 0; node <= highest; ++node)
+        {
+            ULONGLONG mask = 0;
+            if (!GetNumaNodeProcessorMask((UCHAR)node, &mask) || mask == 0)
+            {
+                continue;
+            }
+            std::vector<unsigned int> cpus;
+            for (unsigned int cpu = 0; cpu != 64; ++cpu)
+            {
+                if (mask & (1ull << cpu))
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+            topology.nodes.push_back(std::move(cpus));
+        }
+    }
+#else
+    for (unsigned int node = 0;; ++node)
+    {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file)
+        {
+            break;
+        }
+        std::string list;
+        std::getline(file, list);
+        auto cpus = parseCpuList(list);
+        if (!cpus.empty())
+        {
+            topology.nodes.push_back(std::move(cpus));
+        }
+    }
+#endif
+
+    if (topology.nodes.empty())
+    {
+        std::vector<unsigned int> cpus(std::max(1u, std::thread::hardware_concurrency()));
+        std::iota(cpus.begin(), cpus.end(), 0u);
+        topology.nodes.push_back(std::move(cpus));
+    }
+    return topology;
+}
+
+inline unsigned int CpuTopology::nodeCount() const
+{
+    return (unsigned int)nodes.size();
+}
+
+inline unsigned int CpuTopology::cpuCount() const
+{
+    unsigned int count = 0;
+    for (const auto& cpus : nodes)
+    {
+        count += (unsigned int)cpus.size();
+    }
+    return count;
+}
+
+inline int CpuTopology::nodeOfCpu(unsigned int cpu) const
+{
+    for (size_t node = 0; node != nodes.size(); ++node)
+    {
+        if (std::find(nodes[node].begin(), nodes[node].end(), cpu) != nodes[node].end())
+        {
+            return (int)node;
+        }
+    }
+    return -1;
+}
+
+inline std::vector<unsigned int> CpuTopology::parseCpuList(const std::string& list)
+{
+    std::vector<unsigned int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ','))
+    {
+        if (range.empty() || !std::isdigit((unsigned char)range[0]))
+        {
+            continue;
+        }
+        unsigned int first = (unsigned int)std::stoul(range);
+        unsigned int last = first;
+        auto dash = range.find('-');
+        if (dash != std::string::npos)
+        {
+            last = (unsigned int)std::stoul(range.substr(dash + 1));
+        }
+        for (unsigned int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+inline bool setThreadAffinity(std::thread::native_handle_type thread, const std::vector<unsigned int>& cpus)
+{
+    if (cpus.empty())
+    {
+        return false;
+    }
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (auto cpu : cpus)
+    {
+        if (cpu < sizeof(DWORD_PTR) * 8)
+        {
+            mask |= (DWORD_PTR)1 << cpu;
+        }
+    }
+    return mask != 0 && SetThreadAffinityMask((HANDLE)thread, mask) != 0;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+#endif
+}
+
+inline bool setCurrentThreadAffinity(const std::vector<unsigned int>& cpus)
+{
+#ifdef _WIN32
+    return setThreadAffinity(GetCurrentThread(), cpus);
+#else
+    return setThreadAffinity(pthread_self(), cpus);
+#endif
+}
@@ -1,38 +1,216 @@
 #pragma once
 
+#include "task.h"
+#include "executor.h"
+#include "future.h"
 #include "syncqueue.h"
+#include "prioritysyncqueue.h"
+#include "workstealqueue.h"
+#include "topology.h"
+#include "workerstats.h"
+#include "rwlock.h"
 
-class WorkerPool
+class WorkerPool : public Executor
 {
+public:
+    enum class Mode
+    {
+        SingleQueue,    //all workers share one queue
+        WorkStealing,   //one deque per worker, idle workers steal from others
+    };
+
+    using Priority = TaskPriority;
+    using Clock = PrioritySyncQueue<Task>::Clock;
+    using LaneStats = PrioritySyncQueue<priv::QueuedTask>::LaneStats;
+
+    //point in time view, taken without stopping the workers
+    struct Stats
+    {
+        struct Worker
+        {
+            bool active = false;
+            uint64_t tasks = 0;
+            uint64_t stolen = 0;
+            uint64_t busyNanos = 0;
+            uint64_t aliveNanos = 0;
+            LogLinearHistogram::Snapshot runTime;
+            LogLinearHistogram::Snapshot queueLatency;
+
+            double utilisation() const
+            {
+                return aliveNanos ? (double)busyNanos / aliveNanos : 0.0;
+            }
+        };
+
+        size_t queued = 0;
+        std::vector<Worker> workers;
+
+        //all workers merged
+        LogLinearHistogram::Snapshot runTime() const;
+        LogLinearHistogram::Snapshot queueLatency() const;
+    };
+
+    //co_await pool.schedule() continues the coroutine on a pool thread
+    struct ScheduleAwaiter
+    {
+        WorkerPool* pool;
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        //a stopped pool would never run the handle, continue on the calling thread instead
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            //the handle fits Task's inline buffer, resuming costs no allocation
+            return pool->tryAdd([handle]() {
+                handle.resume();
+            });
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+private:
+    struct WorkerContext
+    {
+        WorkerPool* pool = nullptr;
+        unsigned int index = 0;
+        WorkerStats* stats = nullptr;
+    };
+
+    struct WorkerSlot
+    {
+        WorkStealQueue<priv::QueuedTask> tasks;
+        std::atomic<int> node = -1;
+    };
+
     std::vector<std::thread> threads_;
-    SyncQueue<std::function<void()>> tasks_;
+    PrioritySyncQueue<priv::QueuedTask> tasks_;
     std::mutex lock_;
     std::atomic<bool> running_ = false;
+    //tryAdd holds it shared, stop() takes it only to clear running_
+    RWSpinLock addLock_;
+    std::atomic<unsigned int> size_ = 0;
+
+    std::mutex threadsLock_;
+    std::vector<std::thread> retired_;
+    std::atomic<int> idle_ = 0;
+    std::atomic<bool> elastic_ = false;
+    std::atomic<unsigned int> minThreads_ = 0;
+    std::atomic<unsigned int> maxThreads_ = 0;
+    std::atomic<int64_t> keepAliveMicros_ = 0;
+    std::atomic<int64_t> spinMicros_ = 0;
+
+    std::vector<std::vector<unsigned int>> placementCpus_;
+    std::vector<int> placementNodes_;
+
+    Mode mode_ = Mode::SingleQueue;
+    std::vector<std::unique_ptr<WorkerSlot>> workers_;
+    std::atomic<unsigned int> nextQueue_ = 0;
+    std::atomic<int> pending_ = 0;
+    std::atomic<int> sleeping_ = 0;
+    std::mutex parkLock_;
+    std::condition_variable parkCv_;
+
+#ifdef WORKERPOOL_ENABLE_STATS
+    //slots are reused by later threads and never freed while the pool lives
+    std::mutex statsLock_;
+    std::vector<std::unique_ptr<WorkerStats>> stats_;
+#endif
 
     WorkerPool(const WorkerPool&) = delete;
     WorkerPool& operator=(const WorkerPool&) = delete;
 
 public:
-    explicit WorkerPool(unsigned int size = std::thread::hardware_concurrency());
+    explicit WorkerPool(unsigned int size = std::thread::hardware_concurrency(), Mode mode = Mode::SingleQueue);
     ~WorkerPool();
 
     //default
     static WorkerPool* pool();
-    static void async(const std::function<void()>& task);
-    static void async(std::function<void()>&& task);
+    static void async(Task&& task);
+
+    //for blocking calls (files, sockets, databases), elastic with its own thread budget
+    //so blocked threads never take workers away from pool()
+    static WorkerPool* ioPool();
+    static void asyncIo(Task&& task);
+
+    //Executor
+    void post(Task&& task) override;
+    bool tryPost(Task&& task) override;
+
+    ScheduleAwaiter schedule();
+
+    void add(Task&& task);
+    //add unless the pool is stopped, a refused task is left in task
+    bool tryAdd(Task&& task);
+    //tasks still queued when deadline passes are dropped without running
+    void add(Task&& task, Priority priority, Clock::time_point deadline = Clock::time_point());
+
+    //run func on the pool, the returned future holds its result or exception
+    template<class F>
+    auto submit(F&& func) -> Future<std::invoke_result_t<std::decay_t<F>>>;
 
-    void add(const std::function<void()>& task);
-    void add(std::function<void()>&& task);
+    //enqueue every callable of the range under a single lock and wake workers once
+    template<class Range>
+    void add_bulk(Range&& tasks);
 
     void restart(unsigned int size);
     void stop();
 
+    Mode mode() const;
+    unsigned int size() const;
+
+    //a lower lane task waiting longer than limit is served before higher lanes.
+    //in work stealing mode the lanes only see tasks added with a priority other than Normal or a deadline
+    void setStarvationLimit(std::chrono::microseconds limit);
+    LaneStats laneStats(Priority priority);
+
+    //SingleQueue mode: keep between minThreads and maxThreads workers, a worker is added when queued
+    //tasks outnumber idle workers and retired after staying idle for keepAlive
+    void setElastic(unsigned int minThreads, unsigned int maxThreads, std::chrono::milliseconds keepAlive = std::chrono::milliseconds(1000));
+    //idle workers keep polling (with yield) for this long before they park
+    void setSpinPeriod(std::chrono::microseconds spin);
+
+    //pin worker i to cpus[i % cpus.size()], applies to running and future workers
+    void pinWorkers(const std::vector<unsigned int>& cpus, const CpuTopology& topology = CpuTopology::detect());
+    //let worker i run on any cpu of node i % nodeCount
+    void spreadOverNodes(const CpuTopology& topology = CpuTopology::detect());
+    //WorkStealing mode: queue on a worker placed on node so the task runs near its data,
+    //without placement or in SingleQueue mode this is a plain add
+    void addOnNode(Task&& task, unsigned int node);
+
+    //per worker counters are only filled in with WORKERPOOL_ENABLE_STATS defined
+    Stats stats();
+
 protected:
     void start(unsigned int size);
     void threadRun();
+
+    void maybeGrow();
+    bool grow();
+    bool retire();
+    template<class Ready> bool spin(Ready ready);
+
+    static WorkerContext& currentWorker();
+    void push(Task&& task);
+    void pushTo(unsigned int index, Task&& task);
+    void place(size_t slot);
+    template<class It> void pushBulk(It first, It last);
+    void wakeSleeping(bool all);
+    bool takeTask(unsigned int index, priv::QueuedTask& task);
+    void stealingThreadRun(unsigned int index);
+
+    void runTask(priv::QueuedTask& task);
+    void attachStats();
+    void detachStats();
 };
 
-inline WorkerPool::WorkerPool(unsigned int size /*= std::thread::hardware_concurrency()*/)
+inline WorkerPool::WorkerPool(unsigned int size /*= std::thread::hardware_concurrency()*/, Mode mode /*= Mode::SingleQueue*/)
+    : mode_(mode)
 {
     start(size);
 }
@@ -49,24 +227,121 @@ inline WorkerPool* WorkerPool::pool()
     return &pool;
 }
 
-inline void WorkerPool::async(const std::function<void()>& task)
+inline void WorkerPool::async(Task&& task)
+{
+    pool()->add(std::move(task));
+}
+
+inline WorkerPool* WorkerPool::ioPool()
+{
+    static WorkerPool* pool = []() {
+        static WorkerPool io(1);
+        io.setElastic(1, std::max(16u, std::thread::hardware_concurrency() * 4), std::chrono::seconds(10));
+        return &io;
+    }();
+    return pool;
+}
+
+inline void WorkerPool::asyncIo(Task&& task)
+{
+    ioPool()->add(std::move(task));
+}
+
+inline void WorkerPool::post(Task&& task)
+{
+    add(std::move(task));
+}
+
+inline bool WorkerPool::tryPost(Task&& task)
 {
-    pool()->add(task);
+    return tryAdd(std::move(task));
 }
 
-inline void WorkerPool::async(std::function<void()>&& task)
+inline WorkerPool::ScheduleAwaiter WorkerPool::schedule()
 {
-    pool()->add(move(task));
+    return ScheduleAwaiter{ this };
 }
 
-inline void WorkerPool::add(const std::function<void()>& task)
+inline void WorkerPool::add(Task&& task)
 {
-    tasks_.enqueue(task);
+    if (mode_ == Mode::WorkStealing)
+    {
+        push(std::move(task));
+        return;
+    }
+    tasks_.enqueue(std::move(task));
+    maybeGrow();
+}
+
+inline bool WorkerPool::tryAdd(Task&& task)
+{
+    //stop() clears running_ under the exclusive side, no add can slip in between the check and the queue
+    std::shared_lock<RWSpinLock> addLock(addLock_);
+    if (!running_)
+    {
+        return false;
+    }
+    add(std::move(task));
+    return true;
 }
 
-inline void WorkerPool::add(std::function<void()>&& task)
+inline void WorkerPool::add(Task&& task, Priority priority, Clock::time_point deadline /*= Clock::time_point()*/)
 {
-    tasks_.enqueue(move(task));
+    //in work stealing mode plain normal tasks stay on the deques, anything else goes through the lanes
+    if (mode_ == Mode::WorkStealing && priority == Priority::Normal && deadline == Clock::time_point())
+    {
+        push(std::move(task));
+        return;
+    }
+    tasks_.enqueue(std::move(task), priority, deadline);
+    if (mode_ == Mode::WorkStealing)
+    {
+        wakeSleeping(false);
+        return;
+    }
+    maybeGrow();
+}
+
+template<class F>
+auto WorkerPool::submit(F&& func) -> Future<std::invoke_result_t<std::decay_t<F>>>
+{
+    using R = std::invoke_result_t<std::decay_t<F>>;
+    Promise<R> promise;
+    Future<R> future = promise.future();
+    add([promise = std::move(promise), func = std::forward<F>(func)]() mutable {
+        promise.run(func);
+    });
+    return future;
+}
+
+template<class Range>
+void WorkerPool::add_bulk(Range&& tasks)
+{
+    //an rvalue range gives up its callables, an lvalue range is copied
+    std::vector<Task> batch;
+    for (auto&& task : tasks)
+    {
+        if constexpr (std::is_lvalue_reference<Range>::value)
+        {
+            batch.emplace_back(task);
+        }
+        else
+        {
+            batch.emplace_back(std::move(task));
+        }
+    }
+    if (batch.empty())
+    {
+        return;
+    }
+
+    if (mode_ == Mode::WorkStealing)
+    {
+        pushBulk(batch.begin(), batch.end());
+        return;
+    }
+    tasks_.enqueueBulk(batch.begin(), batch.end());
+    maybeGrow();
 }
 
 inline void WorkerPool::restart(unsigned int size)
@@ -83,13 +358,136 @@ inline void WorkerPool::stop()
         return;
     }
 
-    running_ = false;
+    {
+        //a tryAdd either got in before this or sees the pool stopped
+        std::unique_lock<RWSpinLock> addLock(addLock_);
+        running_ = false;
+    }
     tasks_.stop();
-    for (auto& thread : threads_)
+    {
+        std::lock_guard<std::mutex> parkLock(parkLock_);
+        parkCv_.notify_all();
+    }
+
+    //joined outside threadsLock_, a retiring worker may be waiting for it
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> threadsLock(threadsLock_);
+        threads = std::move(threads_);
+        threads_.clear();
+        std::move(retired_.begin(), retired_.end(), std::back_inserter(threads));
+        retired_.clear();
+    }
+    for (auto& thread : threads)
     {
         thread.join();
     }
-    threads_.clear();
+    size_ = 0;
+    for (auto& worker : workers_)
+    {
+        worker->tasks.clear();
+    }
+    pending_ = 0;
+}
+
+inline WorkerPool::Mode WorkerPool::mode() const
+{
+    return mode_;
+}
+
+inline unsigned int WorkerPool::size() const
+{
+    return size_;
+}
+
+inline void WorkerPool::setStarvationLimit(std::chrono::microseconds limit)
+{
+    tasks_.setStarvationLimit(limit);
+}
+
+inline WorkerPool::LaneStats WorkerPool::laneStats(Priority priority)
+{
+    return tasks_.stats(priority);
+}
+
+inline void WorkerPool::setElastic(unsigned int minThreads, unsigned int maxThreads, std::chrono::milliseconds keepAlive /*= std::chrono::milliseconds(1000)*/)
+{
+    assert(minThreads <= maxThreads);
+    minThreads_ = minThreads;
+    maxThreads_ = maxThreads;
+    keepAliveMicros_ = std::chrono::duration_cast<std::chrono::microseconds>(keepAlive).count();
+    elastic_ = mode_ == Mode::SingleQueue && maxThreads > 0;
+
+    while (elastic_ && size_ < minThreads_ && grow())
+    {
+    }
+}
+
+inline void WorkerPool::setSpinPeriod(std::chrono::microseconds spin)
+{
+    spinMicros_ = spin.count();
+}
+
+inline void WorkerPool::pinWorkers(const std::vector<unsigned int>& cpus, const CpuTopology& topology /*= CpuTopology::detect()*/)
+{
+    std::lock_guard<std::mutex> lock(threadsLock_);
+    placementCpus_.clear();
+    placementNodes_.clear();
+    for (auto cpu : cpus)
+    {
+        placementCpus_.push_back({ cpu });
+        placementNodes_.push_back(topology.nodeOfCpu(cpu));
+    }
+    for (size_t slot = 0; slot != threads_.size(); ++slot)
+    {
+        place(slot);
+    }
+}
+
+inline void WorkerPool::spreadOverNodes(const CpuTopology& topology /*= CpuTopology::detect()*/)
+{
+    std::lock_guard<std::mutex> lock(threadsLock_);
+    placementCpus_ = topology.nodes;
+    placementNodes_.resize(topology.nodes.size());
+    std::iota(placementNodes_.begin(), placementNodes_.end(), 0);
+    for (size_t slot = 0; slot != threads_.size(); ++slot)
+    {
+        place(slot);
+    }
+}
+
+inline void WorkerPool::addOnNode(Task&& task, unsigned int node)
+{
+    if (mode_ == Mode::WorkStealing)
+    {
+        const unsigned int count = size_;
+        const unsigned int start = nextQueue_.fetch_add(1, std::memory_order_relaxed);
+        for (unsigned int i = 0; i != count; ++i)
+        {
+            unsigned int index = (start + i) % count;
+            if (workers_[index]->node == (int)node)
+            {
+                pushTo(index, std::move(task));
+                return;
+            }
+        }
+    }
+    add(std::move(task));
+}
+
+inline void WorkerPool::place(size_t slot)
+{
+    //threadsLock_ is held
+    if (placementCpus_.empty() || slot >= threads_.size())
+    {
+        return;
+    }
+    size_t entry = slot % placementCpus_.size();
+    setThreadAffinity(threads_[slot].native_handle(), placementCpus_[entry]);
+    if (slot < workers_.size())
+    {
+        workers_[slot]->node = placementNodes_[entry];
+    }
 }
 
 inline void WorkerPool::start(unsigned int size)
@@ -99,32 +497,373 @@ inline void WorkerPool::start(unsigned int size)
     {
         return;
     }
+    std::lock_guard<std::mutex> threadsLock(threadsLock_);
     running_ = true;
     tasks_.start();
+    if (mode_ == Mode::WorkStealing)
+    {
+        size = std::max(size, 1u);
+        while (workers_.size() < size)
+        {
+            workers_.push_back(std::make_unique<WorkerSlot>());
+        }
+        for (unsigned int i = 0; i != size; ++i)
+        {
+            threads_.push_back(std::thread(&WorkerPool::stealingThreadRun, this, i));
+            place(i);
+        }
+        size_ = size;
+        return;
+    }
     for (unsigned int i = 0; i != size; ++i)
     {
+        idle_ += 1;
         threads_.push_back(std::thread(&WorkerPool::threadRun, this));
+        place(i);
     }
+    size_ = size;
 }
 
 inline void WorkerPool::threadRun()
 {
+    //idle_ already counts this worker, whoever spawned it added it
+    attachStats();
     while (true)
     {
-        std::function<void()> func;
-        if (tasks_.dequeue(func))
+        priv::QueuedTask func;
+        bool got = spin([this]() { return tasks_.size() != 0 || !running_; }) && tasks_.try_dequeue(func);
+        if (!got)
+        {
+            int64_t keepAlive = elastic_ ? keepAliveMicros_.load() : 0;
+            got = keepAlive > 0
+                ? tasks_.dequeue(func, std::chrono::microseconds(keepAlive))
+                : tasks_.dequeue(func);
+        }
+
+        if (!running_)
+        {
+            break;
+        }
+
+        if (got)
+        {
+            idle_ -= 1;
+            runTask(func);
+            idle_ += 1;
+        }
+        else if (retire())
+        {
+            //retire() already took this worker out of idle_
+            detachStats();
+            return;
+        }
+    }
+    idle_ -= 1;
+    detachStats();
+}
+
+inline void WorkerPool::maybeGrow()
+{
+    while (elastic_ && tasks_.size() > (size_t)idle_.load() && size_ < maxThreads_ && grow())
+    {
+    }
+}
+
+inline bool WorkerPool::grow()
+{
+    std::lock_guard<std::mutex> lock(threadsLock_);
+    if (!running_ || size_ >= maxThreads_)
+    {
+        return false;
+    }
+
+    for (auto& thread : retired_)
+    {
+        thread.join();
+    }
+    retired_.clear();
+
+    idle_ += 1;
+    threads_.push_back(std::thread(&WorkerPool::threadRun, this));
+    place(threads_.size() - 1);
+    size_ += 1;
+    return true;
+}
+
+inline bool WorkerPool::retire()
+{
+    std::lock_guard<std::mutex> lock(threadsLock_);
+    if (!running_ || !elastic_ || size_ <= minThreads_)
+    {
+        return false;
+    }
+
+    auto self = std::this_thread::get_id();
+    auto it = std::find_if(threads_.begin(), threads_.end(), [&self](const std::thread& thread) {
+        return thread.get_id() == self;
+    });
+    if (it == threads_.end())
+    {
+        return false;
+    }
+
+    //leave idle_ before looking at the queue: an add() that raced with us either shows up in
+    //tasks_ here, or sees one idle worker less and grows the pool itself
+    idle_ -= 1;
+    if (tasks_.size() != 0)
+    {
+        idle_ += 1;
+        return false;
+    }
+
+    //the thread object is joined by the next grow() or stop()
+    retired_.push_back(std::move(*it));
+    threads_.erase(it);
+    size_ -= 1;
+    return true;
+}
+
+template<class Ready>
+bool WorkerPool::spin(Ready ready)
+{
+    const int64_t spinMicros = spinMicros_;
+    if (spinMicros <= 0)
+    {
+        return false;
+    }
+
+    auto until = Clock::now() + std::chrono::microseconds(spinMicros);
+    while (!ready())
+    {
+        if (Clock::now() >= until)
+        {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+inline WorkerPool::WorkerContext& WorkerPool::currentWorker()
+{
+    static thread_local WorkerContext context;
+    return context;
+}
+
+inline void WorkerPool::push(Task&& task)
+{
+    //tasks posted from our own worker stay local, others are spread round robin
+    const WorkerContext& context = currentWorker();
+    unsigned int index = context.pool == this
+        ? context.index
+        : nextQueue_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+    pushTo(index, std::move(task));
+}
+
+inline void WorkerPool::pushTo(unsigned int index, Task&& task)
+{
+    workers_[index]->tasks.push(std::move(task));
+    pending_.fetch_add(1);
+
+    wakeSleeping(false);
+}
+
+template<class It>
+void WorkerPool::pushBulk(It first, It last)
+{
+    //a worker keeps its batch local for the others to steal, other threads split it over all deques
+    const int count = (int)std::distance(first, last);
+    const WorkerContext& context = currentWorker();
+    if (context.pool == this)
+    {
+        workers_[context.index]->tasks.pushBulk(first, last);
+    }
+    else
+    {
+        const int queues = (int)workers_.size();
+        const int chunk = (count + queues - 1) / queues;
+        unsigned int index = nextQueue_.fetch_add(1, std::memory_order_relaxed);
+        while (first != last)
+        {
+            It next = std::next(first, std::min<int>(chunk, (int)std::distance(first, last)));
+            workers_[index++ % queues]->tasks.pushBulk(first, next);
+            first = next;
+        }
+    }
+    pending_.fetch_add(count);
+
+    wakeSleeping(true);
+}
+
+inline void WorkerPool::wakeSleeping(bool all)
+{
+    if (sleeping_.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(parkLock_);
+        if (all)
+        {
+            parkCv_.notify_all();
+        }
+        else
+        {
+            parkCv_.notify_one();
+        }
+    }
+}
+
+inline bool WorkerPool::takeTask(unsigned int index, priv::QueuedTask& task)
+{
+    //high lane first, then our own deque, then stealing, background last
+    if (tasks_.size() != 0 && tasks_.try_dequeue(task, Priority::High))
+    {
+        return true;
+    }
+
+    if (workers_[index]->tasks.pop(task))
+    {
+        pending_.fetch_sub(1);
+        return true;
+    }
+
+    //victims on our own node first
+    const int node = workers_[index]->node;
+    const unsigned int count = (unsigned int)workers_.size();
+    for (int pass = 0; pass != 2; ++pass)
+    {
+        for (unsigned int i = 1; i != count; ++i)
         {
-            if (!running_)
+            WorkerSlot& victim = *workers_[(index + i) % count];
+            if ((victim.node == node) != (pass == 0))
             {
-                break;
+                continue;
             }
+            if (victim.tasks.steal(task))
+            {
+                pending_.fetch_sub(1);
+#ifdef WORKERPOOL_ENABLE_STATS
+                LogLinearHistogram::bump(currentWorker().stats->stolen, 1);
+#endif
+                return true;
+            }
+        }
+    }
+    return tasks_.size() != 0 && tasks_.try_dequeue(task);
+}
+
+inline void WorkerPool::stealingThreadRun(unsigned int index)
+{
+    WorkerContext& context = currentWorker();
+    context.pool = this;
+    context.index = index;
+    attachStats();
 
-            func();
+    while (running_)
+    {
+        priv::QueuedTask func;
+        if (takeTask(index, func))
+        {
+            runTask(func);
+            continue;
         }
 
-        if (!running_)
+        if (spin([this]() { return !running_ || pending_.load() > 0 || tasks_.size() != 0; }))
         {
-            break;
+            continue;
         }
+
+        std::unique_lock<std::mutex> lock(parkLock_);
+        sleeping_.fetch_add(1);
+        parkCv_.wait(lock, [this]() {
+            return !running_ || pending_.load() > 0 || tasks_.size() != 0;
+        });
+        sleeping_.fetch_sub(1);
+    }
+
+    detachStats();
+    context.pool = nullptr;
+}
+
+inline void WorkerPool::runTask(priv::QueuedTask& task)
+{
+#ifdef WORKERPOOL_ENABLE_STATS
+    uint64_t start = priv::statsNanos();
+    task.task();
+    uint64_t end = priv::statsNanos();
+    currentWorker().stats->record(start - std::min(start, task.queued), end - start);
+#else
+    task();
+#endif
+}
+
+inline void WorkerPool::attachStats()
+{
+#ifdef WORKERPOOL_ENABLE_STATS
+    std::lock_guard<std::mutex> lock(statsLock_);
+    auto it = std::find_if(stats_.begin(), stats_.end(), [](const std::unique_ptr<WorkerStats>& stats) {
+        return !stats->active;
+    });
+    if (it == stats_.end())
+    {
+        stats_.push_back(std::make_unique<WorkerStats>());
+        it = stats_.end() - 1;
+    }
+    (*it)->active = true;
+    (*it)->sinceNanos = priv::statsNanos();
+    currentWorker().stats = it->get();
+#endif
+}
+
+inline void WorkerPool::detachStats()
+{
+#ifdef WORKERPOOL_ENABLE_STATS
+    std::lock_guard<std::mutex> lock(statsLock_);
+    WorkerStats* stats = currentWorker().stats;
+    stats->aliveNanos += priv::statsNanos() - stats->sinceNanos;
+    stats->active = false;
+    currentWorker().stats = nullptr;
+#endif
+}
+
+inline WorkerPool::Stats WorkerPool::stats()
+{
+    Stats stats;
+    stats.queued = tasks_.size() + (size_t)std::max(0, pending_.load());
+#ifdef WORKERPOOL_ENABLE_STATS
+    const uint64_t now = priv::statsNanos();
+    std::lock_guard<std::mutex> lock(statsLock_);
+    for (const auto& slot : stats_)
+    {
+        Stats::Worker worker;
+        worker.active = slot->active;
+        worker.tasks = slot->tasks.load(std::memory_order_relaxed);
+        worker.stolen = slot->stolen.load(std::memory_order_relaxed);
+        worker.busyNanos = slot->busyNanos.load(std::memory_order_relaxed);
+        worker.aliveNanos = slot->aliveNanos + (slot->active ? now - slot->sinceNanos : 0);
+        worker.runTime = slot->runTime.snapshot();
+        worker.queueLatency = slot->queueLatency.snapshot();
+        stats.workers.push_back(std::move(worker));
+    }
+#endif
+    return stats;
+}
+
+inline LogLinearHistogram::Snapshot WorkerPool::Stats::runTime() const
+{
+    LogLinearHistogram::Snapshot merged;
+    for (const auto& worker : workers)
+    {
+        merged.merge(worker.runTime);
+    }
+    return merged;
+}
+
+inline LogLinearHistogram::Snapshot WorkerPool::Stats::queueLatency() const
+{
+    LogLinearHistogram::Snapshot merged;
+    for (const auto& worker : workers)
+    {
+        merged.merge(worker.queueLatency);
     }
+    return merged;
 }
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "task.h"
+
+//define WORKERPOOL_ENABLE_STATS before including workerpool.h to have every worker record
+//task counts, busy time, run time and queue latency histograms. without it nothing is recorded
+//and WorkerPool::stats() only reports the queue depth.
+//the macro changes WorkerPool's layout, set it for the whole target (DEFINES in the .pro),
+//every translation unit must agree. msvc refuses to link ones that do not.
+#ifdef _MSC_VER
+#ifdef WORKERPOOL_ENABLE_STATS
+#pragma detect_mismatch("WORKERPOOL_ENABLE_STATS", "1")
+#else
+#pragma detect_mismatch("WORKERPOOL_ENABLE_STATS", "0")
+#endif
+#endif
+
+//log linear histogram of nanoseconds: 4 linear buckets per power of two, a bucket is within 25% of its values.
+//recorded by a single thread without read-modify-write, any thread may take a snapshot meanwhile.
+class LogLinearHistogram
+{
+public:
+    static constexpr int kSubBits = 2;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kBuckets = (64 - kSubBits + 1) * kSub;
+
+    struct Snapshot
+    {
+        std::array<uint64_t, kBuckets> counts = {};
+        uint64_t count = 0;
+        uint64_t sum = 0;
+
+        void merge(const Snapshot& other)
+        {
+            for (int i = 0; i != kBuckets; ++i)
+            {
+                counts[i] += other.counts[i];
+            }
+            count += other.count;
+            sum += other.sum;
+        }
+
+        double mean() const
+        {
+            return count ? (double)sum / count : 0.0;
+        }
+
+        //lower bound of the bucket holding the p-th value, p in [0, 1]
+        uint64_t percentile(double p) const
+        {
+            if (count == 0)
+            {
+                return 0;
+            }
+            uint64_t rank = (uint64_t)(p * (count - 1));
+            uint64_t seen = 0;
+            for (int i = 0; i != kBuckets; ++i)
+            {
+                seen += counts[i];
+                if (seen > rank)
+                {
+                    return lowerBound(i);
+                }
+            }
+            return lowerBound(kBuckets - 1);
+        }
+    };
+
+    static int bucketOf(uint64_t value)
+    {
+        if (value < kSub)
+        {
+            return (int)value;
+        }
+        int exponent = (int)std::bit_width(value) - 1;
+        int sub = (int)(value >> (exponent - kSubBits)) & (kSub - 1);
+        return (exponent - kSubBits + 1) * kSub + sub;
+    }
+
+    static uint64_t lowerBound(int bucket)
+    {
+        if (bucket < kSub)
+        {
+            return (uint64_t)bucket;
+        }
+        int exponent = bucket / kSub + kSubBits - 1;
+        return (uint64_t)(kSub + bucket % kSub) << (exponent - kSubBits);
+    }
+
+    void record(uint64_t value)
+    {
+        bump(counts_[bucketOf(value)], 1);
+        bump(count_, 1);
+        bump(sum_, value);
+    }
+
+    Snapshot snapshot() const
+    {
+        Snapshot snapshot;
+        for (int i = 0; i != kBuckets; ++i)
+        {
+            snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        }
+        snapshot.count = count_.load(std::memory_order_relaxed);
+        snapshot.sum = sum_.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    //single writer, a plain load and store is enough and avoids a locked instruction
+    static void bump(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> counts_[kBuckets] = {};
+    std::atomic<uint64_t> count_ = 0;
+    std::atomic<uint64_t> sum_ = 0;
+};
+
+//counters of one worker thread, on their own cache lines so workers never share one
+struct alignas(64) WorkerStats
+{
+    std::atomic<uint64_t> tasks = 0;
+    std::atomic<uint64_t> stolen = 0;
+    std::atomic<uint64_t> busyNanos = 0;
+    LogLinearHistogram runTime;
+    LogLinearHistogram queueLatency;
+
+    //owned by the pool's stats lock, a slot is reused by later threads
+    bool active = false;
+    uint64_t sinceNanos = 0;
+    uint64_t aliveNanos = 0;
+
+    void record(uint64_t latencyNanos, uint64_t runNanos)
+    {
+        LogLinearHistogram::bump(tasks, 1);
+        LogLinearHistogram::bump(busyNanos, runNanos);
+        runTime.record(runNanos);
+        queueLatency.record(latencyNanos);
+    }
+};
+
+namespace priv
+{
+    inline uint64_t statsNanos()
+    {
+        using namespace std::chrono;
+        return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+#ifdef WORKERPOOL_ENABLE_STATS
+    //Task plus the time it was queued
+    struct StampedTask
+    {
+        Task task;
+        uint64_t queued = 0;
+
+        StampedTask() = default;
+        StampedTask(Task&& func)
+            : task(std::move(func)), queued(statsNanos())
+        {
+        }
+    };
+
+    using QueuedTask = StampedTask;
+#else
+    using QueuedTask = Task;
+#endif
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+//per worker task deque, owner works on the back, thieves take from the front
+template<class T>
+class WorkStealQueue
+{
+    std::mutex mutex_;
+    std::deque<T> queue_;
+
+    WorkStealQueue(const WorkStealQueue&) = delete;
+    WorkStealQueue &operator=(const WorkStealQueue &) = delete;
+
+public:
+    WorkStealQueue() = default;
+
+    bool isEmpty();
+    void clear();
+
+    void push(const T& item);
+    void push(T&& item);
+    template<class It> void pushBulk(It first, It last);
+
+    bool pop(T& item);
+    bool steal(T& item);
+};
+
+template<class T> bool WorkStealQueue<T>::isEmpty()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return queue_.empty();
+}
+
+template<class T> void WorkStealQueue<T>::clear()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.clear();
+}
+
+template<class T> void WorkStealQueue<T>::push(const T& item)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.push_back(item);
+}
+
+template<class T> void WorkStealQueue<T>::push(T&& item)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(item));
+}
+
+template<class T> template<class It> void WorkStealQueue<T>::pushBulk(It first, It last)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (; first != last; ++first)
+    {
+        queue_.push_back(std::move(*first));
+    }
+}
+
+template<class T> bool WorkStealQueue<T>::pop(T& item)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (queue_.empty())
+    {
+        return false;
+    }
+
+    item = std::move(queue_.back());
+    queue_.pop_back();
+    return true;
+}
+
+template<class T> bool WorkStealQueue<T>::steal(T& item)
+{
+    //never wait on a busy victim, just try the next one
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || queue_.empty())
+    {
+        return false;
+    }
+
+    item = std::move(queue_.front());
+    queue_.pop_front();
+    return true;
+}